@@ -36,6 +36,37 @@
 #define configUSE_QUEUE_SETS					1
 #define configUSE_TASK_NOTIFICATIONS			1
 
+/* Virtual time: the tick count only moves while every task is blocked, and
+then jumps straight to the next unblock time instead of waiting for it in real
+time.  Selected from the Makefile with SIM_TIME=virtual. */
+#ifndef configUSE_VIRTUAL_TIME
+	#define configUSE_VIRTUAL_TIME				0
+#endif
+
+/* Tickless idle: in virtual time the idle task jumps the tick count, in real
+time it sleeps with the tick timer stopped instead of taking a tick every
+millisecond. */
+#define configUSE_TICKLESS_IDLE					1
+
+/* Keep the delayed tasks in a hierarchical timing wheel instead of the two
+sorted delayed lists, so blocking costs the same however many tasks are
+already delayed.  Selected from the Makefile with DELAYED_LIST=wheel. */
+#ifndef configUSE_DELAYED_TASK_WHEEL
+	#define configUSE_DELAYED_TASK_WHEEL		0
+#endif
+
+/* Create the simulation's tasks and mutexes from pools sized once before the
+scheduler starts (Project/alocacao.c) instead of from the heap, and count any
+heap allocation made after vTaskStartScheduler().  Selected from the Makefile
+with ALLOCATION=static. */
+#ifndef configSUPPORT_STATIC_ALLOCATION
+	#define configSUPPORT_STATIC_ALLOCATION		0
+#endif
+#if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+	extern unsigned long ulAlocacoesAposPartida;
+	#define traceMALLOC( pvAddress, uiSize )	do { if( xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED ) ulAlocacoesAposPartida++; } while( 0 )
+#endif
+
 /* Software timer related configuration options. */
 #define configUSE_TIMERS						1
 #define configTIMER_TASK_PRIORITY				( configMAX_PRIORITIES - 1 )
@@ -46,6 +77,14 @@
 
 #define configGENERATE_RUN_TIME_STATS		1
 
+/* Count the context switches reported by the -m metrics (Project/metricas.c).
+The macros expand inside vTaskSwitchContext(), where pxCurrentTCB is visible;
+reselecting the task that was already running is not counted. */
+extern void *pvTarefaAnterior;
+extern unsigned long ulTrocasDeContexto;
+#define traceTASK_SWITCHED_OUT()	pvTarefaAnterior = pxCurrentTCB
+#define traceTASK_SWITCHED_IN()		do { if( pxCurrentTCB != pvTarefaAnterior ) ulTrocasDeContexto++; } while( 0 )
+
 /* Set the following definitions to 1 to include the API function, or zero
 to exclude the API function.  In most cases the linker will remove unused
 functions anyway. */
@@ -0,0 +1,237 @@
+#include <FreeRTOS.h>
+#include <task.h>
+#include <stdio.h>
+
+#include "simulacao.h"
+#include "agentes.h"
+#include "eventos.h"
+#include "roda.h"
+#include "alocacao.h"
+
+typedef enum {
+    AGENTE_APROXIMANDO,   // Sorteia velocidade e entra na via
+    AGENTE_AGUARDANDO,    // Aguarda espaço na via, que estava lotada
+    AGENTE_NA_VIA,        // Percorre a via e para na fila do movimento, até o cruzamento liberá-lo
+    AGENTE_ATRAVESSANDO,  // Atravessa o cruzamento
+    AGENTE_FINALIZADO     // Jornada encerrada
+} estado_agente_t;
+
+// Tabela de veículos como estrutura de vetores: cada campo é um vetor contíguo,
+// então a memória por veículo é só a soma dos campos
+typedef struct {
+    uint32_t quantidade;
+    uint32_t *id;               // Identificador do veículo
+    uint32_t *via;              // Via da rede pela qual o veículo se aproxima do cruzamento
+    char *movimento;            // 'L' para esquerda, 'R' para direita, 'F' para frente
+    float *velocidade;          // Velocidade do veículo em km/h
+    uint16_t *tempo_percurso;   // Tempo de percurso da via em segundos
+    uint8_t *estado;            // estado_agente_t
+    aleatorio_t *gerador;       // Gerador pseudoaleatório de cada veículo
+    uint32_t *proximo;          // Próximo veículo no mesmo compartimento da roda do lote
+    uint32_t *passo;            // Passo da próxima ação do veículo (ETA)
+} tabela_agentes_t;
+
+// Fatia da tabela avançada por uma tarefa trabalhadora, com a roda das
+// próximas ações dos seus veículos e seus contadores
+typedef struct {
+    uint32_t inicio;
+    uint32_t fim;
+    roda_t roda;
+    uint32_t travessias;
+    uint32_t finalizados;
+    uint64_t atualizacoes;      // Ações de veículos executadas (métricas)
+} lote_agentes_t;
+
+static tabela_agentes_t tabela;
+static lote_agentes_t *lotes = NULL;
+static int num_lotes = 0;
+
+// Agenda a próxima ação do veículo 'i' do lote para o tick 'prazo'
+static void agendarAgente(lote_agentes_t *lote, uint32_t i, TickType_t prazo) {
+    taskENTER_CRITICAL(); // A tarefa do cruzamento também agenda os veículos que libera
+    agendarRoda(&lote->roda, i, passoDoPrazo(prazo));
+    taskEXIT_CRITICAL();
+}
+
+// Lote do veículo 'i': os lotes são faixas contíguas de tamanhos quase iguais
+static lote_agentes_t *loteDoAgente(uint32_t i) {
+    int t = (int)((uint64_t)i * num_lotes / tabela.quantidade);
+
+    while (i >= lotes[t].fim) {
+        t++;
+    }
+    while (i < lotes[t].inicio) {
+        t--;
+    }
+    return &lotes[t];
+}
+
+// Executa a próxima ação de um veículo, espelhando vVeiculoTask
+static void avancarAgente(lote_agentes_t *lote, uint32_t i, TickType_t agora) {
+    uint32_t destino = rede.destino[tabela.via[i]];
+    uint32_t proxima_via;
+
+    switch (tabela.estado[i]) {
+        case AGENTE_ATRAVESSANDO:
+            lote->travessias++;
+
+            // Seleciona o próximo cruzamento ou finaliza a jornada
+            proxima_via = VIA_INEXISTENTE;
+            if (sortearIntervalo(&tabela.gerador[i], 2) == 0 && tabela.movimento[i] != 'F') {
+                proxima_via = selecionarProximaVia(destino, &tabela.gerador[i]);
+            }
+            if (proxima_via == VIA_INEXISTENTE) {
+                tabela.estado[i] = AGENTE_FINALIZADO;
+                lote->finalizados++;
+                registrarEvento(agora, EVENTO_FIM_JORNADA, tabela.id[i], destino, tabela.movimento[i], 0, 0);
+                break;
+            }
+            tabela.via[i] = proxima_via;
+            destino = rede.destino[proxima_via];
+            registrarEvento(agora, EVENTO_PROXIMO_CRUZAMENTO, tabela.id[i], destino, tabela.movimento[i], 0, 0);
+            // fallthrough
+        case AGENTE_APROXIMANDO:
+            tabela.velocidade[i] = sortearVelocidade(tabela.via[i], &tabela.gerador[i]);
+            // fallthrough
+        case AGENTE_AGUARDANDO:
+            // O estado muda antes de entrar na via: o cruzamento pode liberar o veículo logo em seguida
+            tabela.estado[i] = AGENTE_NA_VIA;
+            if (!entrarNaVia(tabela.via[i], i, tabela.movimento[i], tabela.velocidade[i], agora, &tabela.tempo_percurso[i])) {
+                // Via lotada, tenta novamente em 1 segundo
+                tabela.estado[i] = AGENTE_AGUARDANDO;
+                agendarAgente(lote, i, agora + pdMS_TO_TICKS(1000));
+                break;
+            }
+            registrarEvento(agora, EVENTO_APROXIMACAO, tabela.id[i], destino, tabela.movimento[i],
+                            tabela.velocidade[i], tabela.tempo_percurso[i]);
+            break;
+        default:
+            break;
+    }
+}
+
+// Tarefa trabalhadora: a cada passo avança os veículos do seu lote cujo
+// prazo venceu, tirados da roda, sem percorrer os que estão esperando
+static void vTrabalhadorAgentesTask(void *pvParameters) {
+    lote_agentes_t *lote = (lote_agentes_t *)pvParameters;
+    TickType_t ultimo_passo = xTaskGetTickCount();
+
+    while (1) {
+        vTaskDelayUntil(&ultimo_passo, pdMS_TO_TICKS(PASSO_AGENTES_MS));
+        TickType_t agora = xTaskGetTickCount();
+        uint32_t passo = agora / pdMS_TO_TICKS(PASSO_AGENTES_MS);
+
+        while ((int32_t)(passo - lote->roda.atual) >= 0) {
+            uint32_t i;
+
+            taskENTER_CRITICAL();
+            i = expirarRoda(&lote->roda);
+            taskEXIT_CRITICAL();
+            while (i != RODA_VAZIA) {
+                uint32_t proximo = tabela.proximo[i]; // avancarAgente pode agendar o veículo de novo
+
+                avancarAgente(lote, i, agora);
+                lote->atualizacoes++;
+                i = proximo;
+            }
+        }
+    }
+}
+
+// Aloca a tabela com 'quantidade' veículos, cada um com um gerador semeado
+// por 'semente' e seu id, e cria as tarefas trabalhadoras
+bool criarAgentes(uint32_t quantidade, int trabalhadores, uint64_t semente) {
+    if (quantidade == 0 || trabalhadores <= 0) {
+        return false;
+    }
+    if ((uint32_t)trabalhadores > quantidade) {
+        trabalhadores = (int)quantidade;
+    }
+
+    tabela.quantidade = quantidade;
+    tabela.id = pvPortMalloc(quantidade * sizeof(*tabela.id));
+    tabela.via = pvPortMalloc(quantidade * sizeof(*tabela.via));
+    tabela.movimento = pvPortMalloc(quantidade * sizeof(*tabela.movimento));
+    tabela.velocidade = pvPortMalloc(quantidade * sizeof(*tabela.velocidade));
+    tabela.tempo_percurso = pvPortMalloc(quantidade * sizeof(*tabela.tempo_percurso));
+    tabela.estado = pvPortMalloc(quantidade * sizeof(*tabela.estado));
+    tabela.gerador = pvPortMalloc(quantidade * sizeof(*tabela.gerador));
+    tabela.proximo = pvPortMalloc(quantidade * sizeof(*tabela.proximo));
+    tabela.passo = pvPortMalloc(quantidade * sizeof(*tabela.passo));
+    lotes = pvPortMalloc(trabalhadores * sizeof(*lotes));
+    if (!tabela.id || !tabela.via || !tabela.movimento || !tabela.velocidade || !tabela.tempo_percurso ||
+        !tabela.estado || !tabela.gerador || !tabela.proximo || !tabela.passo || !lotes) {
+        return false;
+    }
+
+    // Atribui uma via e um movimento aleatórios, como no modo de tarefas
+    for (uint32_t i = 0; i < quantidade; i++) {
+        tabela.id[i] = i + 1; // ID do veículo começa em 1
+        iniciarAleatorio(&tabela.gerador[i], semente, tabela.id[i]);
+        tabela.via[i] = sortearIntervalo(&tabela.gerador[i], rede.num_vias);
+        tabela.movimento[i] = sortearMovimento(&tabela.gerador[i]);
+        tabela.velocidade[i] = 0;
+        tabela.tempo_percurso[i] = 0;
+        tabela.estado[i] = AGENTE_APROXIMANDO;
+    }
+
+    // Divide a tabela em lotes contíguos, um por trabalhadora
+    num_lotes = trabalhadores;
+    for (int t = 0; t < trabalhadores; t++) {
+        lotes[t].inicio = (uint32_t)((uint64_t)quantidade * t / trabalhadores);
+        lotes[t].fim = (uint32_t)((uint64_t)quantidade * (t + 1) / trabalhadores);
+        lotes[t].travessias = 0;
+        lotes[t].finalizados = 0;
+        lotes[t].atualizacoes = 0;
+
+        // Todos os veículos do lote agem no primeiro passo
+        iniciarRoda(&lotes[t].roda, tabela.proximo, tabela.passo);
+        for (uint32_t i = lotes[t].inicio; i < lotes[t].fim; i++) {
+            agendarRoda(&lotes[t].roda, i, 0);
+        }
+
+        if (criarTarefa(vTrabalhadorAgentesTask,
+                "Agentes Task",
+                0,
+                &lotes[t],
+                2) == NULL) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Libera o veículo 'i' da fila em que está: ele atravessa o cruzamento a
+// partir de 'agora'. Chamada pela tarefa do cruzamento.
+void liberarAgente(uint32_t i, TickType_t agora) {
+    TickType_t travessia = sortearTravessia(&tabela.gerador[i]); // O veículo está parado: só o cruzamento usa o gerador
+
+    tabela.estado[i] = AGENTE_ATRAVESSANDO; // Fora da roda: nenhuma trabalhadora vê o veículo antes de agendado
+    agendarAgente(loteDoAgente(i), i, agora + travessia);
+    registrarEvento(agora, EVENTO_TRAVESSIA, tabela.id[i], rede.destino[tabela.via[i]], tabela.movimento[i],
+                    tabela.velocidade[i], tabela.tempo_percurso[i]);
+}
+
+// Imprime o total de travessias e de jornadas finalizadas
+void imprimirResumoAgentes(void) {
+    uint32_t travessias = 0;
+    uint32_t finalizados = 0;
+
+    for (int t = 0; t < num_lotes; t++) {
+        travessias += lotes[t].travessias;
+        finalizados += lotes[t].finalizados;
+    }
+    printf("Agentes: %u veículos, %u travessias, %u jornadas finalizadas\n",
+           (unsigned)tabela.quantidade, (unsigned)travessias, (unsigned)finalizados);
+}
+
+// Soma as ações de veículos executadas pelas trabalhadoras
+uint64_t totalAtualizacoesAgentes(void) {
+    uint64_t total = 0;
+
+    for (int t = 0; t < num_lotes; t++) {
+        total += lotes[t].atualizacoes;
+    }
+    return total;
+}
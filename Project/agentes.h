@@ -0,0 +1,24 @@
+#ifndef AGENTES_H
+#define AGENTES_H
+
+// Modo de agentes: os veículos são registros de uma tabela, avançados em lotes
+// por poucas tarefas trabalhadoras, em vez de uma tarefa (e uma pilha) por veículo
+
+#include <FreeRTOS.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TRABALHADORES_AGENTES 4 // tarefas trabalhadoras padrão
+#define PASSO_AGENTES_MS 1000   // intervalo entre lotes (resolução do modo de agentes)
+
+// Passo em que vence o prazo 'prazo' (em ticks): o primeiro passo no prazo ou depois dele
+static inline uint32_t passoDoPrazo(TickType_t prazo) {
+    return (uint32_t)((prazo + pdMS_TO_TICKS(PASSO_AGENTES_MS) - 1) / pdMS_TO_TICKS(PASSO_AGENTES_MS));
+}
+
+bool criarAgentes(uint32_t quantidade, int trabalhadores, uint64_t semente);
+void liberarAgente(uint32_t i, TickType_t agora);
+void imprimirResumoAgentes(void);
+uint64_t totalAtualizacoesAgentes(void);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef ALEATORIO_H
+#define ALEATORIO_H
+
+// Gerador pseudoaleatório PCG32 (XSH RR) com estado de 64 bits, um por
+// veículo. Cada gerador é semeado com a semente da simulação e um fluxo (o
+// id do veículo), então a mesma semente reproduz a mesma execução e os
+// veículos não disputam o estado global de rand().
+
+#include <stdint.h>
+
+#define ALEATORIO_INCREMENTO 1442695040888963407ull // Incremento (ímpar) da recorrência do PCG
+#define ALEATORIO_MULTIPLICADOR 6364136223846793005ull
+
+typedef struct {
+    uint64_t estado;
+} aleatorio_t;
+
+// Sorteia 32 bits e avança o gerador
+static inline uint32_t sortearAleatorio(aleatorio_t *gerador) {
+    uint64_t anterior = gerador->estado;
+    uint32_t misturado = (uint32_t)(((anterior >> 18) ^ anterior) >> 27);
+    uint32_t rotacao = (uint32_t)(anterior >> 59);
+
+    gerador->estado = anterior * ALEATORIO_MULTIPLICADOR + ALEATORIO_INCREMENTO;
+    return (misturado >> rotacao) | (misturado << ((-rotacao) & 31));
+}
+
+// Sorteia um inteiro em [0, limite) por multiplicação, sem divisão
+static inline uint32_t sortearIntervalo(aleatorio_t *gerador, uint32_t limite) {
+    return (uint32_t)(((uint64_t)sortearAleatorio(gerador) * limite) >> 32);
+}
+
+// Semeia o gerador a partir da semente da simulação e do fluxo. O splitmix64
+// espalha sementes e fluxos vizinhos por todo o espaço de estados.
+static inline void iniciarAleatorio(aleatorio_t *gerador, uint64_t semente, uint32_t fluxo) {
+    uint64_t z = semente + (uint64_t)fluxo * 0x9E3779B97F4A7C15ull;
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    gerador->estado = z ^ (z >> 31);
+    sortearAleatorio(gerador);
+}
+
+#endif
@@ -0,0 +1,138 @@
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+
+#include "alocacao.h"
+
+#if configSUPPORT_STATIC_ALLOCATION == 1
+
+unsigned long ulAlocacoesAposPartida = 0;
+
+// Reservas usadas em ordem e nunca devolvidas: as tarefas e os mutexes da
+// simulação duram até o fim da execução
+static StaticTask_t *tcbs = NULL;
+static uint32_t num_tcbs = 0, tcbs_usados = 0;
+static uint8_t *pilhas = NULL;
+static size_t bytes_pilhas_reservados = 0, bytes_pilhas_usados = 0;
+static StaticSemaphore_t *mutexes_reservados = NULL;
+static uint32_t num_mutexes = 0, mutexes_usados = 0;
+
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer,
+                                   uint32_t *pulIdleTaskStackSize);
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer,
+                                    uint32_t *pulTimerTaskStackSize);
+
+// Memória das tarefas ociosa e de timers, criadas por vTaskStartScheduler()
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer,
+                                   uint32_t *pulIdleTaskStackSize) {
+    static StaticTask_t tcb;
+    static StackType_t pilha[configMINIMAL_STACK_SIZE];
+
+    *ppxIdleTaskTCBBuffer = &tcb;
+    *ppxIdleTaskStackBuffer = pilha;
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer,
+                                    uint32_t *pulTimerTaskStackSize) {
+    static StaticTask_t tcb;
+    static StackType_t pilha[configTIMER_TASK_STACK_DEPTH];
+
+    *ppxTimerTaskTCBBuffer = &tcb;
+    *ppxTimerTaskStackBuffer = pilha;
+    *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+
+// Reserva, antes do agendador, 'tarefas' TCBs, 'bytes_pilhas' bytes para as
+// pilhas delas e 'mutexes' mutexes
+bool reservarObjetos(uint32_t tarefas, size_t bytes_pilhas, uint32_t mutexes) {
+    tcbs = pvPortMalloc(tarefas * sizeof(*tcbs));
+    pilhas = pvPortMalloc(bytes_pilhas);
+    mutexes_reservados = pvPortMalloc(mutexes * sizeof(*mutexes_reservados));
+    if ((tarefas > 0 && tcbs == NULL) || (bytes_pilhas > 0 && pilhas == NULL) ||
+        (mutexes > 0 && mutexes_reservados == NULL)) {
+        return false;
+    }
+    num_tcbs = tarefas;
+    bytes_pilhas_reservados = bytes_pilhas;
+    num_mutexes = mutexes;
+    return true;
+}
+
+// As tarefas executam nas pilhas da reserva, e o porte só inicia de antemão
+// threads com pilhas alocadas por ele: não há threads a reservar
+void reservarThreads(uint32_t tarefas, size_t pilha) {
+    (void)tarefas;
+    (void)pilha;
+}
+
+// Cria a tarefa com o próximo TCB da reserva e 'pilha' bytes dela (0 =
+// PILHA_TAREFA), onde a tarefa executa de fato; NULL se a reserva acabou
+TaskHandle_t criarTarefa(TaskFunction_t funcao, const char *nome, size_t pilha, void *parametro, UBaseType_t prioridade) {
+    TaskHandle_t tarefa;
+    uint8_t *memoria;
+
+    if (pilha == 0) {
+        pilha = PILHA_TAREFA;
+    }
+    if (tcbs_usados == num_tcbs || bytes_pilhas_reservados - bytes_pilhas_usados < pilha) {
+        return NULL;
+    }
+    memoria = pilhas + bytes_pilhas_usados;
+
+    vPortSetTaskStackSize(pilha);
+    vPortSetTaskStack(memoria);
+    tarefa = xTaskCreateStatic(funcao, nome, pilha / sizeof(StackType_t), parametro, prioridade,
+                               (StackType_t *)memoria, &tcbs[tcbs_usados]);
+    vPortSetTaskStack(NULL);
+    vPortSetTaskStackSize(0); // Demais tarefas usam a pilha padrão
+    tcbs_usados++;
+    bytes_pilhas_usados += pilha;
+    return tarefa;
+}
+
+// Cria um mutex com o próximo da reserva; NULL se a reserva acabou
+SemaphoreHandle_t criarMutex(void) {
+    if (mutexes_usados == num_mutexes) {
+        return NULL;
+    }
+    return xSemaphoreCreateMutexStatic(&mutexes_reservados[mutexes_usados++]);
+}
+
+#else
+
+// Sem alocação estática não há reservas: tudo vem do heap
+bool reservarObjetos(uint32_t tarefas, size_t bytes_pilhas, uint32_t mutexes) {
+    (void)tarefas;
+    (void)bytes_pilhas;
+    (void)mutexes;
+    return true;
+}
+
+// Inicia de antemão as threads de 'tarefas' tarefas com 'pilha' bytes de
+// pilha (0 = a padrão do porte); criarTarefa com a mesma pilha usa uma delas
+// em vez de iniciar uma thread. Só o porte POSIX tem uma thread por tarefa.
+void reservarThreads(uint32_t tarefas, size_t pilha) {
+    vPortSetTaskStackSize(pilha);
+    vPortReserveTaskThreads(tarefas);
+    vPortSetTaskStackSize(0); // Demais tarefas usam a pilha padrão
+}
+
+// Cria a tarefa no heap com 'pilha' bytes de pilha (0 = a padrão do porte);
+// NULL sem memória
+TaskHandle_t criarTarefa(TaskFunction_t funcao, const char *nome, size_t pilha, void *parametro, UBaseType_t prioridade) {
+    TaskHandle_t tarefa = NULL;
+    BaseType_t criada;
+
+    vPortSetTaskStackSize(pilha);
+    criada = xTaskCreate(funcao, nome, configMINIMAL_STACK_SIZE, parametro, prioridade, &tarefa);
+    vPortSetTaskStackSize(0); // Demais tarefas usam a pilha padrão
+    return criada == pdPASS ? tarefa : NULL;
+}
+
+// Cria um mutex no heap; NULL sem memória
+SemaphoreHandle_t criarMutex(void) {
+    return xSemaphoreCreateMutex();
+}
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef ALOCACAO_H
+#define ALOCACAO_H
+
+// Criação das tarefas e mutexes da simulação. Com make ALLOCATION=static
+// (configSUPPORT_STATIC_ALLOCATION) os TCBs, as pilhas e os mutexes saem de
+// reservas dimensionadas uma única vez por reservarObjetos(), antes do
+// agendador; sem ela, vêm do heap do FreeRTOS como em xTaskCreate. No modo
+// estático, ulAlocacoesAposPartida conta as alocações no heap do FreeRTOS
+// feitas depois de vTaskStartScheduler() (traceMALLOC em FreeRTOSConfig.h).
+// Sem ela, reservarThreads() inicia de antemão as threads das tarefas no porte
+// POSIX (vPortReserveTaskThreads).
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PILHA_TAREFA (64 * 1024) // bytes de pilha das tarefas criadas com pilha 0
+
+#if configSUPPORT_STATIC_ALLOCATION == 1
+extern unsigned long ulAlocacoesAposPartida;
+#endif
+
+bool reservarObjetos(uint32_t tarefas, size_t bytes_pilhas, uint32_t mutexes);
+void reservarThreads(uint32_t tarefas, size_t pilha);
+TaskHandle_t criarTarefa(TaskFunction_t funcao, const char *nome, size_t pilha, void *parametro, UBaseType_t prioridade);
+SemaphoreHandle_t criarMutex(void);
+
+#endif
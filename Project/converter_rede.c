@@ -0,0 +1,19 @@
+#include <stdio.h>
+
+#include "rede.h"
+
+// Converte uma rede em texto para o formato binário, que o simulador mapeia
+// com mmap em vez de ler e montar a cada execução
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "Uso: %s <rede.txt> <rede.bin>\n", argv[0]);
+        return 1;
+    }
+
+    if (!carregarRede(argv[1]) || !salvarRedeBinaria(argv[2])) {
+        return 1;
+    }
+
+    printf("%s: %u cruzamentos, %u vias\n", argv[2], (unsigned)rede.num_cruzamentos, (unsigned)rede.num_vias);
+    return 0;
+}
@@ -0,0 +1,355 @@
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+#include <stream_buffer.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include "rede.h"
+#include "eventos.h"
+#include "alocacao.h"
+
+#define EVENTOS_MASCARA (EVENTOS_CAPACIDADE - 1)
+#define ESPERA_DESCARREGADOR_NS 1000000 // 1 ms sem eventos antes de verificar o anel de novo
+#define EVENTO_ESVAZIAR 0               // Marcador interno: a tarefa registradora avisa quem pediu ao chegar nele
+#define LINHA_MAXIMA 512                // Espaço reservado para formatar uma linha de texto
+
+// Posição do anel: 'sequencia' indica se o evento já foi publicado pelo
+// produtor (posição + 1) ou liberado pelo descarregador (posição + capacidade)
+typedef struct {
+    atomic_uint sequencia;
+    evento_t evento;
+} posicao_anel_t;
+
+static posicao_anel_t anel[EVENTOS_CAPACIDADE];
+static atomic_uint cabeca;          // Próxima posição a reservar pelos produtores
+static unsigned int cauda;          // Próxima posição a ler, só usada pelo descarregador
+static atomic_bool encerrando;
+
+static int descritor_texto = -1;    // Saída legível (depuração), -1 se desligada
+static StreamBufferHandle_t pendentes_texto = NULL; // Eventos à espera da tarefa registradora
+static SemaphoreHandle_t escrita_texto = NULL;      // Serializa os produtores do stream buffer
+#if configSUPPORT_STATIC_ALLOCATION == 1
+static uint8_t area_texto[EVENTOS_TEXTO_PENDENTES * sizeof(evento_t) + 1]; // O stream buffer usa um byte a mais
+static StaticStreamBuffer_t estrutura_texto;
+#endif
+static TaskHandle_t tarefa_esvaziando = NULL;       // Tarefa que espera o texto pendente ser escrito
+static int descritor_binario = -1;  // Saída binária, -1 se desligada
+static pthread_t descarregador;
+
+// Escreve todo o bloco, repetindo em escritas parciais
+static bool escreverTudo(const void *dados, size_t tamanho) {
+    const char *posicao = dados;
+
+    while (tamanho > 0) {
+        ssize_t escrito = write(descritor_binario, posicao, tamanho);
+        if (escrito < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        posicao += escrito;
+        tamanho -= (size_t)escrito;
+    }
+    return true;
+}
+
+// Copia para 'lote' os eventos já publicados, em ordem, e libera suas posições
+static size_t retirarEventos(evento_t *lote, size_t maximo) {
+    size_t quantidade = 0;
+
+    while (quantidade < maximo) {
+        posicao_anel_t *posicao = &anel[cauda & EVENTOS_MASCARA];
+
+        if (atomic_load_explicit(&posicao->sequencia, memory_order_acquire) != cauda + 1) {
+            break; // Ainda não publicado
+        }
+        lote[quantidade++] = posicao->evento;
+        atomic_store_explicit(&posicao->sequencia, cauda + EVENTOS_CAPACIDADE, memory_order_release);
+        cauda++;
+    }
+    return quantidade;
+}
+
+// Thread do sistema que grava os eventos do anel em lotes
+static void *descarregarEventos(void *parametro) {
+    static evento_t lote[EVENTOS_POR_LOTE];
+    const struct timespec espera = { 0, ESPERA_DESCARREGADOR_NS };
+    bool falhou = false;
+
+    (void)parametro;
+    while (1) {
+        // Lê o pedido de encerramento antes de esvaziar o anel, para não perder os últimos eventos
+        bool ultimo = atomic_load(&encerrando);
+        size_t quantidade = retirarEventos(lote, EVENTOS_POR_LOTE);
+
+        if (quantidade > 0) {
+            if (!falhou && !escreverTudo(lote, quantidade * sizeof(evento_t))) {
+                fprintf(stderr, "Erro ao gravar os eventos: %s\n", strerror(errno));
+                falhou = true; // Continua esvaziando o anel para não travar os produtores
+            }
+        } else if (ultimo) {
+            break;
+        } else {
+            nanosleep(&espera, NULL);
+        }
+    }
+    return NULL;
+}
+
+// Formata o evento no texto legível de antes do registro binário e devolve o
+// número de bytes escritos em 'destino'
+static int formatarEvento(const evento_t *evento, char *destino, size_t tamanho) {
+    const char *cruzamento = nomeCruzamento(evento->cruzamento);
+
+    switch (evento->tipo) {
+        case EVENTO_FASE:
+            if (evento->movimento == 'N') {
+                return snprintf(destino, tamanho, "Cruzamento %s: Fase NS-Straight e EW-Left\n", cruzamento);
+            } else if (evento->movimento == 'E') {
+                return snprintf(destino, tamanho, "Cruzamento %s: Fase EW-Straight e NS-Left\n", cruzamento);
+            } else {
+                return snprintf(destino, tamanho, "Cruzamento %s: Permissão para conversão à direita\n", cruzamento);
+            }
+        case EVENTO_APROXIMACAO:
+            return snprintf(destino, tamanho, "Veículo %u se aproximando do cruzamento %s para mover %c com velocidade %.2f km/h. Tempo de percurso: %u segundos\n",
+                    (unsigned)evento->veiculo, cruzamento, evento->movimento, evento->velocidade, (unsigned)evento->tempo_percurso);
+        case EVENTO_TRAVESSIA:
+            if (evento->movimento == 'F') {
+                return snprintf(destino, tamanho, "Veículo %u atravessou o cruzamento %s em frente\n", (unsigned)evento->veiculo, cruzamento);
+            } else if (evento->movimento == 'L') {
+                return snprintf(destino, tamanho, "Veículo %u virou à esquerda no cruzamento %s\n", (unsigned)evento->veiculo, cruzamento);
+            } else {
+                return snprintf(destino, tamanho, "Veículo %u virou à direita no cruzamento %s\n", (unsigned)evento->veiculo, cruzamento);
+            }
+        case EVENTO_PROXIMO_CRUZAMENTO:
+            return snprintf(destino, tamanho, "Veículo %u se dirigindo ao próximo cruzamento %s\n", (unsigned)evento->veiculo, cruzamento);
+        case EVENTO_FIM_JORNADA:
+            return snprintf(destino, tamanho, "Veículo %u finalizou sua jornada\n", (unsigned)evento->veiculo);
+    }
+    return 0;
+}
+
+// Escreve o texto formatado de uma vez, repetindo em escritas parciais. Usa
+// write() no descritor e não stdio (nem fileno()) para não segurar a trava do
+// FILE enquanto o porte suspende ou cancela a tarefa.
+static void escreverTexto(const char *texto, size_t tamanho) {
+    while (tamanho > 0) {
+        ssize_t escrito = write(descritor_texto, texto, tamanho);
+        if (escrito < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        texto += escrito;
+        tamanho -= (size_t)escrito;
+    }
+}
+
+// Tarefa registradora: recebe os eventos em lotes pelo stream buffer, formata
+// e escreve o texto com uma escrita por lote
+static void vRegistradorTask(void *pvParameters) {
+    static evento_t lote[EVENTOS_TEXTO_PENDENTES];
+    static char texto[TEXTO_POR_LOTE];
+
+    (void)pvParameters;
+    while (1) {
+        // Os produtores enviam eventos inteiros, então o recebido é sempre múltiplo de sizeof(evento_t)
+        size_t recebidos = xStreamBufferReceive(pendentes_texto, lote, sizeof(lote), portMAX_DELAY) / sizeof(evento_t);
+        size_t usado = 0;
+
+        for (size_t i = 0; i < recebidos; i++) {
+            if (lote[i].tipo == EVENTO_ESVAZIAR) {
+                escreverTexto(texto, usado);
+                usado = 0;
+                xTaskNotifyGive(tarefa_esvaziando);
+                continue;
+            }
+            if (TEXTO_POR_LOTE - usado < LINHA_MAXIMA) {
+                escreverTexto(texto, usado);
+                usado = 0;
+            }
+            int tamanho = formatarEvento(&lote[i], texto + usado, LINHA_MAXIMA);
+            if (tamanho > 0) {
+                usado += (size_t)tamanho < LINHA_MAXIMA ? (size_t)tamanho : LINHA_MAXIMA - 1;
+            }
+        }
+        escreverTexto(texto, usado);
+    }
+}
+
+// Cria o stream buffer e a tarefa registradora da saída legível
+static bool iniciarRegistrador(void) {
+    descritor_texto = STDOUT_FILENO;
+    // O restante do texto (printf) continua em stdio; com buffer de linha ele
+    // sai na ordem em que foi produzido em relação às linhas da registradora
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+#if configSUPPORT_STATIC_ALLOCATION == 1
+    pendentes_texto = xStreamBufferCreateStatic(sizeof(area_texto) - 1, sizeof(evento_t), area_texto, &estrutura_texto);
+#else
+    pendentes_texto = xStreamBufferCreate(EVENTOS_TEXTO_PENDENTES * sizeof(evento_t), sizeof(evento_t));
+#endif
+    escrita_texto = criarMutex();
+    if (pendentes_texto == NULL || escrita_texto == NULL) {
+        return false;
+    }
+    return criarTarefa(vRegistradorTask,
+            "Registrador",
+            0,
+            NULL,
+            tskIDLE_PRIORITY + 1) != NULL;
+}
+
+// Copia o evento para o stream buffer da tarefa registradora. O stream buffer
+// só admite um produtor bloqueado por vez, então o envio fica sob o mutex.
+static void enviarTexto(const evento_t *evento) {
+    xSemaphoreTake(escrita_texto, portMAX_DELAY);
+    xStreamBufferSend(pendentes_texto, evento, sizeof(*evento), portMAX_DELAY);
+    xSemaphoreGive(escrita_texto);
+}
+
+// Abre a saída binária (arquivo, ou "-" para a saída padrão) e inicia o
+// descarregador; 'texto' liga a saída legível. Deve ser chamada depois de
+// carregar a rede, cujos nomes vão no cabeçalho.
+bool iniciarEventos(const char *arquivo, bool texto) {
+    cabecalho_eventos_t cabecalho;
+    sigset_t todos, anteriores;
+
+    if (texto && !iniciarRegistrador()) {
+        fprintf(stderr, "Não foi possível criar a tarefa registradora\n");
+        return false;
+    }
+    if (arquivo == NULL) {
+        return true;
+    }
+
+    if (strcmp(arquivo, "-") == 0) {
+        // Os eventos ficam com a saída padrão; o restante do texto vai para a saída de erro
+        fflush(stdout);
+        descritor_binario = dup(STDOUT_FILENO);
+        if (descritor_binario >= 0 && dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+            close(descritor_binario);
+            descritor_binario = -1;
+        }
+    } else {
+        descritor_binario = open(arquivo, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    if (descritor_binario < 0) {
+        fprintf(stderr, "Não foi possível abrir %s: %s\n", arquivo, strerror(errno));
+        return false;
+    }
+
+    memset(&cabecalho, 0, sizeof(cabecalho));
+    memcpy(cabecalho.magica, EVENTOS_MAGICA, sizeof(EVENTOS_MAGICA));
+    cabecalho.versao = EVENTOS_VERSAO;
+    cabecalho.tamanho_evento = sizeof(evento_t);
+    cabecalho.ticks_por_segundo = configTICK_RATE_HZ;
+    cabecalho.num_cruzamentos = rede.num_cruzamentos;
+    cabecalho.tamanho_nomes = rede.tamanho_nomes;
+    if (!escreverTudo(&cabecalho, sizeof(cabecalho)) || !escreverTudo(rede.nomes, rede.tamanho_nomes)) {
+        fprintf(stderr, "Erro ao gravar os eventos: %s\n", strerror(errno));
+        return false;
+    }
+
+    for (unsigned int i = 0; i < EVENTOS_CAPACIDADE; i++) {
+        atomic_init(&anel[i].sequencia, i);
+    }
+    atomic_init(&cabeca, 0);
+    atomic_init(&encerrando, false);
+    cauda = 0;
+
+    // O descarregador não pode receber os sinais que o porte usa para o tick e as trocas de contexto
+    sigfillset(&todos);
+    pthread_sigmask(SIG_SETMASK, &todos, &anteriores);
+    if (pthread_create(&descarregador, NULL, descarregarEventos, NULL) != 0) {
+        pthread_sigmask(SIG_SETMASK, &anteriores, NULL);
+        fprintf(stderr, "Não foi possível criar o descarregador de eventos\n");
+        return false;
+    }
+    pthread_sigmask(SIG_SETMASK, &anteriores, NULL);
+    return true;
+}
+
+// Registra um evento: reserva uma posição no anel e publica o evento nela.
+// Com o anel cheio, o produtor espera o descarregador liberar espaço.
+void registrarEvento(TickType_t tick, tipo_evento_t tipo, uint32_t veiculo, uint32_t cruzamento,
+                     char movimento, float velocidade, uint16_t tempo_percurso) {
+    evento_t evento;
+    posicao_anel_t *posicao;
+    unsigned int reserva;
+
+    evento.tick = (uint32_t)tick;
+    evento.veiculo = veiculo;
+    evento.cruzamento = cruzamento;
+    evento.velocidade = velocidade;
+    evento.tempo_percurso = tempo_percurso;
+    evento.tipo = (uint8_t)tipo;
+    evento.movimento = movimento;
+
+    if (descritor_texto >= 0) {
+        enviarTexto(&evento);
+    }
+    if (descritor_binario < 0) {
+        return;
+    }
+
+    reserva = atomic_load_explicit(&cabeca, memory_order_relaxed);
+    while (1) {
+        posicao = &anel[reserva & EVENTOS_MASCARA];
+        int diferenca = (int)(atomic_load_explicit(&posicao->sequencia, memory_order_acquire) - reserva);
+
+        if (diferenca == 0) {
+            // Posição livre: tenta reservá-la; se outro produtor chegou antes, 'reserva' é atualizada
+            if (atomic_compare_exchange_weak_explicit(&cabeca, &reserva, reserva + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diferenca < 0) {
+            // Anel cheio
+            sched_yield();
+            reserva = atomic_load_explicit(&cabeca, memory_order_relaxed);
+        } else {
+            reserva = atomic_load_explicit(&cabeca, memory_order_relaxed);
+        }
+    }
+
+    posicao->evento = evento;
+    atomic_store_explicit(&posicao->sequencia, reserva + 1, memory_order_release);
+}
+
+// Espera a tarefa registradora escrever o texto dos eventos já registrados.
+// Deve ser chamada por uma tarefa, antes de encerrar o escalonador.
+void esvaziarEventos(void) {
+    evento_t marcador;
+
+    if (descritor_texto < 0) {
+        return;
+    }
+    memset(&marcador, 0, sizeof(marcador));
+    marcador.tipo = EVENTO_ESVAZIAR;
+    tarefa_esvaziando = xTaskGetCurrentTaskHandle();
+    enviarTexto(&marcador);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+// Espera o descarregador gravar os eventos restantes e fecha a saída binária
+void finalizarEventos(void) {
+    if (descritor_binario < 0) {
+        return;
+    }
+    atomic_store(&encerrando, true);
+    pthread_join(descarregador, NULL);
+    close(descritor_binario);
+    descritor_binario = -1;
+}
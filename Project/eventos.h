@@ -0,0 +1,58 @@
+#ifndef EVENTOS_H
+#define EVENTOS_H
+
+// Registro de eventos da simulação. Cada evento é um registro binário de
+// tamanho fixo, colocado em um anel sem travas e gravado em lotes por uma
+// thread do sistema, fora do FreeRTOS. O texto legível é opcional (depuração)
+// e é formatado pela tarefa registradora, que recebe os eventos por um
+// stream buffer; as tarefas da simulação só copiam o evento.
+//
+// O fluxo binário começa com cabecalho_eventos_t, seguido dos nomes dos
+// cruzamentos (tamanho_nomes bytes, terminados em '\0', na ordem da rede) e
+// depois dos eventos. ui.py decodifica esse formato.
+
+#include <FreeRTOS.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define EVENTOS_MAGICA "EVENTOS"
+#define EVENTOS_VERSAO 1
+#define EVENTOS_CAPACIDADE 65536 // eventos no anel (potência de 2)
+#define EVENTOS_POR_LOTE 4096    // eventos por escrita no arquivo
+#define EVENTOS_TEXTO_PENDENTES 1024 // eventos no stream buffer da tarefa registradora
+#define TEXTO_POR_LOTE (64 * 1024)   // bytes de texto por escrita da tarefa registradora
+
+typedef enum {
+    EVENTO_FASE = 1,            // Cruzamento abriu uma fase (movimento = 'N', 'E' ou 'X')
+    EVENTO_APROXIMACAO,         // Veículo se aproximando do cruzamento
+    EVENTO_TRAVESSIA,           // Veículo atravessou o cruzamento
+    EVENTO_PROXIMO_CRUZAMENTO,  // Veículo se dirigindo ao próximo cruzamento
+    EVENTO_FIM_JORNADA          // Veículo finalizou a jornada
+} tipo_evento_t;
+
+typedef struct {
+    uint32_t tick;              // Instante do evento, em ticks
+    uint32_t veiculo;           // Identificador do veículo (0 em eventos de cruzamento)
+    uint32_t cruzamento;        // Índice do cruzamento na rede
+    float velocidade;           // Velocidade do veículo em km/h
+    uint16_t tempo_percurso;    // Tempo de percurso em segundos
+    uint8_t tipo;               // tipo_evento_t
+    char movimento;             // 'L', 'R' ou 'F'; fase em EVENTO_FASE
+} evento_t;
+
+typedef struct {
+    char magica[8];             // EVENTOS_MAGICA
+    uint32_t versao;            // EVENTOS_VERSAO
+    uint32_t tamanho_evento;    // sizeof(evento_t)
+    uint32_t ticks_por_segundo;
+    uint32_t num_cruzamentos;
+    uint32_t tamanho_nomes;
+} cabecalho_eventos_t;
+
+bool iniciarEventos(const char *arquivo, bool texto);
+void registrarEvento(TickType_t tick, tipo_evento_t tipo, uint32_t veiculo, uint32_t cruzamento,
+                     char movimento, float velocidade, uint16_t tempo_percurso);
+void esvaziarEventos(void);
+void finalizarEventos(void);
+
+#endif
@@ -5,48 +5,53 @@
 #include <stdlib.h>
 #include <time.h>
 #include <stdbool.h>
+#include <unistd.h>
 
-#define NUM_CRUZAMENTOS 4
-#define NUM_VEICULOS 4
-#define DISTANCIA_CRUZAMENTO 500 // metros
-
-typedef struct {
-    char id;                     // Identificador único do semáforo
-    bool estado;                 // Estado do semáforo (0 = vermelho, 1 = verde)
-    int time_green_red;         // Tempo para vermelho e para o verde para mudar de estado (em segundos)
-    SemaphoreHandle_t key_semaforo;    // Mutex para controle de acesso ao semáforo
-} semaforo_t;
+#include "simulacao.h"
+#include "agentes.h"
+#include "regioes.h"
+#include "eventos.h"
+#include "metricas.h"
+#include "alocacao.h"
 
-typedef struct {
-    char id;                    // Identificador único do cruzamento
-    semaforo_t semaforos[4];      // Semáforos de cada cruzamento
-    SemaphoreHandle_t NS_Straight;           // Permissão para seguir em frente na via NS
-    SemaphoreHandle_t EW_Straight;           // Permissão para seguir em frente na via EW
-    SemaphoreHandle_t NS_Left;               // Permissão para conversão à esquerda na via NS
-    SemaphoreHandle_t EW_Left;               // Permissão para conversão à esquerda na via EW
-    SemaphoreHandle_t XX_Straight;           // Permissão para conversão à direita na via XX
-} cruzamento_t;
+#define NUM_VEICULOS 4
+#define MAX_VEICULOS 4096 // Veículos ao mesmo tempo na rede no modo de tarefas, contando os da demanda
+#define PILHA_VEICULO (32 * 1024) // bytes de pilha da thread de cada veículo
 
 typedef struct {
     int id;                 // Identificador do veículo
-    cruzamento_t *cruzamento;  // Cruzamento que o veículo está tentando atravessar
+    uint32_t indice;        // Posição do veículo em veiculos[] e da sua tarefa em tarefas_veiculos[]
+    uint32_t via;              // Via da rede pela qual o veículo se aproxima do cruzamento (o destino da via)
     char movimento;         // 'L' para esquerda, 'R' para direita, 'F' para frente
     float velocidade;       // Velocidade do veículo em km/h
-    int tempo_percurso;     // Tempo de percurso em segundos
+    uint16_t tempo_percurso;    // Tempo de percurso da via em segundos
+    uint32_t atualizacoes;  // Ações executadas pelo veículo (métricas)
+    aleatorio_t gerador;    // Gerador pseudoaleatório próprio do veículo
 } veiculo_t;
 
 // Prototipação das funções
 void vCruzamentoTask(void *pvParameters);
 void vVeiculoTask(void *pvParameters);
-void criarCruzamentos(void);
-float calcularTempoPercurso(float velocidade);
-char obterFaseSemaforica(cruzamento_t *cruzamento);
-cruzamento_t* selecionarProximoCruzamento(cruzamento_t *atual);
+void vSupervisorTask(void *pvParameters);
+void vDemandaTask(void *pvParameters);
+bool criarCruzamentos(void);
 
 extern void vAssertCalled(unsigned long ulLine, const char * const pcFileName); //funcao acerções??
 void vApplicationIdleHook(void); //funcao ocioso
 
-cruzamento_t cruzamentos[NUM_CRUZAMENTOS]; // cria um vetor de cruzamentos
+cruzamento_t *cruzamentos = NULL; // vetor de cruzamentos, um por cruzamento da rede
+int duracao_simulacao = 0; // Duração da simulação em segundos simulados (0 = sem limite)
+uint32_t num_agentes = 0; // Veículos do modo de agentes (0 = modo de tarefas)
+uint32_t fluxo_saturacao = FLUXO_SATURACAO_PADRAO; // veículos por hora de verde que deixam cada fila
+static veiculo_t veiculos[MAX_VEICULOS]; // Veículos do modo de tarefas, cada um com sua tarefa
+static TaskHandle_t tarefas_veiculos[MAX_VEICULOS]; // Tarefa de cada veículo, liberada pelo cruzamento
+static uint32_t num_veiculos = 0; // Posições de veiculos[] já usadas
+static uint32_t estacionados[MAX_VEICULOS]; // Veículos com a jornada encerrada, à espera de outra
+static uint32_t num_estacionados = 0;
+uint32_t demanda = 0; // Veículos por hora que entram na rede no modo de tarefas (0 = só os iniciais)
+static uint32_t demanda_recusada = 0; // Veículos da demanda que não couberam em MAX_VEICULOS
+static uint64_t semente_simulacao = 0;
+int num_regioes = 0; // Regiões do modo paralelo (0 = agentes avançados pelas trabalhadoras)
 
 void vAssertCalled(unsigned long ulLine, const char * const pcFileName) {
     // Loop infinito em caso de falha
@@ -56,116 +61,171 @@ void vAssertCalled(unsigned long ulLine, const char * const pcFileName) {
 }
 
 void vApplicationIdleHook(void) {
-    // função de ações durante o estado ocioso
+    // Dorme até o próximo tick em vez de girar ocupando um núcleo
+    vPortWaitForTick();
 }
 
 // Função que cria as tarefas dos cruzamentos
-void criarCruzamentos() {
+bool criarCruzamentos() {
+    cruzamentos = pvPortMalloc(rede.num_cruzamentos * sizeof(cruzamento_t));
+    if (cruzamentos == NULL) {
+        return false;
+    }
+
     // Inicializando cruzamentos e semáforos
-    for (int i = 0; i < NUM_CRUZAMENTOS; i++) {
-        cruzamentos[i].id = 'A' + i; // A, B, C, D
+    for (uint32_t i = 0; i < rede.num_cruzamentos; i++) {
+        cruzamentos[i].id = nomeCruzamento(i);
         for (int j = 0; j < 4; j++) {
             cruzamentos[i].semaforos[j].id = j; // Semáforos 0, 1, 2, 3
             cruzamentos[i].semaforos[j].estado = 0; // Inicialmente vermelho
             cruzamentos[i].semaforos[j].time_green_red = 30; // 30 segundos
-            cruzamentos[i].semaforos[j].key_semaforo = xSemaphoreCreateMutex(); // Cria um mutex para cada semáforo
         }
-        cruzamentos[i].NS_Straight = xSemaphoreCreateBinary();
-        cruzamentos[i].EW_Straight = xSemaphoreCreateBinary();
-        cruzamentos[i].NS_Left = xSemaphoreCreateBinary();
-        cruzamentos[i].EW_Left = xSemaphoreCreateBinary();
-        cruzamentos[i].XX_Straight = xSemaphoreCreateBinary();
+        for (int f = 0; f < NUM_FASES; f++) {
+            cruzamentos[i].aproximacoes[f].inicio = 0;
+            cruzamentos[i].aproximacoes[f].quantidade = 0;
+        }
 
         // Cria a tarefa do cruzamento
-        xTaskCreate(vCruzamentoTask, 
-                    "Cruzamento Task", 
-                    configMINIMAL_STACK_SIZE, 
-                    &cruzamentos[i],  // Passa o cruzamento atual como parâmetro
-                    1, 
-                    NULL);
+        if (criarTarefa(vCruzamentoTask,
+                        "Cruzamento Task",
+                        0,
+                        &cruzamentos[i],  // Passa o cruzamento atual como parâmetro
+                        1) == NULL) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Função que passa para as filas do cruzamento, em ordem de chegada em cada
+// via, os veículos que chegaram ao fim das vias de entrada até 'agora'. Com a
+// fila do movimento cheia, o veículo espera no fim da via e segura os de trás.
+static void receberChegadas(cruzamento_t *cruzamento, uint32_t indice, TickType_t agora) {
+    for (uint32_t e = inicio_entradas[indice]; e < inicio_entradas[indice + 1]; e++) {
+        uint32_t via = vias_entrada[e];
+        uint32_t veiculo;
+        char movimento;
+
+        taskENTER_CRITICAL(); // Veículos de outras tarefas entram na via
+        while (chegadaNaVia(via, agora, &veiculo, &movimento) &&
+               entrarFila(&cruzamento->aproximacoes[indiceAproximacao(movimento)], veiculo, via)) {
+            retirarChegada(via);
+        }
+        taskEXIT_CRITICAL();
     }
 }
 
-// Função de tarefa que controla cada cruzamento
+// Função que libera o primeiro veículo da fila, se houver, para atravessar a partir de 'agora'
+static void liberarVeiculo(fila_aproximacao_t *fila, TickType_t agora) {
+    uint32_t veiculo;
+    uint32_t via;
+
+    if (!sairFila(fila, &veiculo, &via)) {
+        return;
+    }
+    taskENTER_CRITICAL(); // Veículos de outras tarefas entram na via
+    sairVia(via);
+    taskEXIT_CRITICAL();
+
+    if (num_agentes > 0) {
+        liberarAgente(veiculo, agora);
+    } else {
+        xTaskNotifyGive(tarefas_veiculos[veiculo]);
+    }
+}
+
+// Função de tarefa que controla cada cruzamento: abre as fases em sequência e,
+// a cada passo, recebe nas filas os veículos que chegaram pelas vias e, no
+// verde de cada fase, libera da fila do seu movimento um veículo por
+// intervalo de saturação
 void vCruzamentoTask(void *pvParameters) {
     cruzamento_t *cruzamento = (cruzamento_t *)pvParameters;
+    uint32_t indice = (uint32_t)(cruzamento - cruzamentos);
+    TickType_t instante = xTaskGetTickCount();
 
     while (1) {
-        // Fase NS-Straight e EW-Left
-        printf("Cruzamento %c: Fase NS-Straight e EW-Left\n", cruzamento->id);
-        xSemaphoreGive(cruzamento->NS_Straight);
-        xSemaphoreGive(cruzamento->EW_Left);
-        vTaskDelay(pdMS_TO_TICKS(10000)); // 10 segundos
-
-        //bloqueia os semáforos
-        xSemaphoreTake(cruzamento->NS_Straight,0);
-        xSemaphoreTake(cruzamento->EW_Left,0);
-
-        // Fase EW-Straight e NS-Left
-        printf("Cruzamento %c: Fase EW-Straight e NS-Left\n", cruzamento->id);
-        xSemaphoreGive(cruzamento->EW_Straight);
-        xSemaphoreGive(cruzamento->NS_Left);
-        vTaskDelay(pdMS_TO_TICKS(10000)); // 10 segundos
-
-        //bloqueia os semáforos
-        xSemaphoreTake(cruzamento->EW_Straight,0);
-        xSemaphoreTake(cruzamento->NS_Left,0);
-
-        // Permite a conversão à direita (XX_Straight)
-        printf("Cruzamento %c: Permissão para conversão à direita\n", cruzamento->id);
-        xSemaphoreGive(cruzamento->XX_Straight);
-        vTaskDelay(pdMS_TO_TICKS(10000)); // 10 segundos
-
-        //bloqueia os semáforos
-        xSemaphoreTake(cruzamento->XX_Straight,0);
+        for (int f = 0; f < NUM_FASES; f++) {
+            TickType_t inicio = instante;
+            TickType_t fim = instante + pdMS_TO_TICKS(DURACAO_FASE_MS);
+            uint32_t saidas = 0;
+
+            registrarEvento(instante, EVENTO_FASE, 0, indice, FASES[f], 0, 0);
+            do {
+                uint32_t liberar = saidasAte(inicio, instante) - saidas;
+
+                receberChegadas(cruzamento, indice, instante);
+                for (; liberar > 0; liberar--, saidas++) {
+                    liberarVeiculo(&cruzamento->aproximacoes[f], instante);
+                }
+                vTaskDelayUntil(&instante, pdMS_TO_TICKS(PASSO_CRUZAMENTO_MS));
+            } while (instante != fim);
+        }
     }
 }
 
-// Função que calcula o tempo de percurso com base na velocidade
-float calcularTempoPercurso(float velocidade) {
+// Função que calcula o tempo de percurso de uma via com base na velocidade
+float calcularTempoPercurso(float velocidade, float comprimento) {
     // Converte velocidade de km/h para m/s (1 km/h = 1000 m / 3600 s)
     float velocidade_ms = (velocidade * 1000) / 3600;
     // Tempo = Distância / Velocidade
-    return DISTANCIA_CRUZAMENTO / velocidade_ms;
+    return comprimento / velocidade_ms;
 }
 
-// Função que obtém a fase semafórica atual de um cruzamento
-char obterFaseSemaforica(cruzamento_t *cruzamento) {
-    if (xSemaphoreTake(cruzamento->NS_Straight, 0)) {
-        xSemaphoreGive(cruzamento->NS_Straight);
-        return 'N'; // NS-Straight e EW-Left
-    } else if (xSemaphoreTake(cruzamento->EW_Straight, 0)) {
-        xSemaphoreGive(cruzamento->EW_Straight);
-        return 'E'; // EW-Straight e NS-Left
-    } else if (xSemaphoreTake(cruzamento->XX_Straight, 0)) {
-        xSemaphoreGive(cruzamento->XX_Straight);
-        return 'X'; // XX-Straight (direita)
-    }
-    return 'U'; // Indeterminado
+// Função que sorteia a velocidade de um veículo conforme a velocidade máxima da via
+float sortearVelocidade(uint32_t via, aleatorio_t *gerador) {
+    float velocidade = rede.velocidade_maxima[via] + ((int)sortearIntervalo(gerador, 11) - 5); // Variação de ±5 km/h
+
+    return velocidade < 1 ? 1 : velocidade;
 }
 
-// Função que seleciona o próximo cruzamento com base na localização atual
-cruzamento_t* selecionarProximoCruzamento(cruzamento_t *atual) {
-    cruzamento_t *proximo = NULL;
-    switch (atual->id) {
-        case 'A':
-            // Pode se mover para B (direita) ou C (baixo)
-            proximo = (rand() % 2 == 0) ? &cruzamentos[1] : &cruzamentos[2];
-            break;
-        case 'B':
-            // Pode se mover para A (esquerda) ou D (baixo)
-            proximo = (rand() % 2 == 0) ? &cruzamentos[0] : &cruzamentos[3];
-            break;
-        case 'C':
-            // Pode se mover para A (cima) ou D (direita)
-            proximo = (rand() % 2 == 0) ? &cruzamentos[0] : &cruzamentos[3];
-            break;
-        case 'D':
-            // Pode se mover para B (cima) ou C (esquerda)
-            proximo = (rand() % 2 == 0) ? &cruzamentos[1] : &cruzamentos[2];
-            break;
+// Função que sorteia o movimento de um veículo: 'L' para esquerda, 'R' para direita, 'F' para frente
+char sortearMovimento(aleatorio_t *gerador) {
+    return sortearIntervalo(gerador, 3) == 0 ? 'L' : sortearIntervalo(gerador, 3) == 1 ? 'R' : 'F';
+}
+
+// Função que obtém a fila do movimento: 'F' sai na fase 'N', 'L' na fase 'E' e 'R' na fase 'X'
+uint32_t indiceAproximacao(char movimento) {
+    switch (movimento) {
+        case 'F':
+            return 0;
+        case 'L':
+            return 1;
+        default:
+            return 2;
     }
-    return proximo;
+}
+
+// Função que obtém o intervalo entre dois veículos que deixam uma fila no verde
+TickType_t intervaloSaturacao(void) {
+    TickType_t intervalo = pdMS_TO_TICKS(3600000 / fluxo_saturacao);
+
+    return intervalo > 0 ? intervalo : 1;
+}
+
+// Função que calcula as saídas de uma fila permitidas entre o início da fase
+// e 'agora': uma a cada intervalo de saturação, a primeira no início da fase
+uint32_t saidasAte(TickType_t inicio_fase, TickType_t agora) {
+    TickType_t intervalo = intervaloSaturacao();
+    uint32_t maximo = (pdMS_TO_TICKS(DURACAO_FASE_MS) + intervalo - 1) / intervalo;
+    uint32_t saidas = (agora - inicio_fase) / intervalo + 1;
+
+    return saidas < maximo ? saidas : maximo;
+}
+
+// Função que sorteia o tempo para atravessar o cruzamento, entre 2 e 5 segundos
+TickType_t sortearTravessia(aleatorio_t *gerador) {
+    return pdMS_TO_TICKS(sortearIntervalo(gerador, 3000) + 2000);
+}
+
+// Função que põe o veículo na via a partir de 'agora'; devolve false com a
+// via lotada (a fila do cruzamento chega até o cruzamento anterior)
+bool entrarNaVia(uint32_t via, uint32_t veiculo, char movimento, float velocidade, TickType_t agora, uint16_t *tempo) {
+    bool entrou;
+
+    taskENTER_CRITICAL(); // O cruzamento de destino e os demais veículos usam a mesma via
+    entrou = entrarVia(via, veiculo, movimento, velocidade, agora, tempo);
+    taskEXIT_CRITICAL();
+    return entrou;
 }
 
 // Função de tarefa que representa um veículo
@@ -175,90 +235,339 @@ void vVeiculoTask(void *pvParameters) {
     while (1) {
         // Simula o movimento do veículo
         // Determina uma velocidade aleatória
-        if (veiculo->cruzamento->id == 'A' || veiculo->cruzamento->id == 'B') {
-            // Vias Norte-Sul
-            veiculo->velocidade = 60 + (rand() % 11 - 5); // Variação de ±5 km/h
-        } else {
-            // Vias Leste-Oeste
-            veiculo->velocidade = 50 + (rand() % 11 - 5); // Variação de ±5 km/h
-        }
+        veiculo->velocidade = sortearVelocidade(veiculo->via, &veiculo->gerador);
 
-        // Calcula o tempo de percurso
-        veiculo->tempo_percurso = calcularTempoPercurso(veiculo->velocidade);
-        printf("Veículo %d se aproximando do cruzamento %c para mover %c com velocidade %.2f km/h. Tempo de percurso: %d segundos\n", 
-               veiculo->id, veiculo->cruzamento->id, veiculo->movimento, veiculo->velocidade, veiculo->tempo_percurso);
-
-        // Verifica o semáforo e se o movimento é permitido
-        while (1) {
-            char fase = obterFaseSemaforica(veiculo->cruzamento);
-            if ((veiculo->movimento == 'F' && fase == 'N') ||
-                (veiculo->movimento == 'L' && fase == 'E') ||
-                (veiculo->movimento == 'R' && fase == 'X')) {
-                // Movimento permitido na fase atual
-                if (veiculo->movimento == 'F' && xSemaphoreTake(veiculo->cruzamento->NS_Straight, portMAX_DELAY)) {
-                    printf("Veículo %d atravessou o cruzamento %c em frente\n", 
-                           veiculo->id, veiculo->cruzamento->id);
-                    vTaskDelay(pdMS_TO_TICKS(veiculo->tempo_percurso * 1000)); // Atravessa o cruzamento
-                    xSemaphoreGive(veiculo->cruzamento->NS_Straight);
-                    break;
-                } else if (veiculo->movimento == 'L' && xSemaphoreTake(veiculo->cruzamento->NS_Left, portMAX_DELAY)) {
-                    printf("Veículo %d virou à esquerda no cruzamento %c\n", 
-                           veiculo->id, veiculo->cruzamento->id);
-                    vTaskDelay(pdMS_TO_TICKS(veiculo->tempo_percurso * 1000)); // Atravessa o cruzamento
-                    xSemaphoreGive(veiculo->cruzamento->NS_Left);
-                    break;
-                } else if (veiculo->movimento == 'R' && xSemaphoreTake(veiculo->cruzamento->XX_Straight, portMAX_DELAY)) {
-                    printf("Veículo %d virou à direita no cruzamento %c\n", 
-                           veiculo->id, veiculo->cruzamento->id);
-                    vTaskDelay(pdMS_TO_TICKS(veiculo->tempo_percurso * 1000)); // Atravessa o cruzamento
-                    xSemaphoreGive(veiculo->cruzamento->XX_Straight);
-                    break;
-                }
-            } else {
-                // Movimento não permitido, aguarda a mudança de fase
-                vTaskDelay(pdMS_TO_TICKS(1000)); // Aguarda 1 segundo antes de verificar novamente
-            }
+        // Entra na via, que calcula o tempo de percurso; com a via lotada, tenta de novo em 1 segundo
+        while (!entrarNaVia(veiculo->via, veiculo->indice, veiculo->movimento, veiculo->velocidade,
+                            xTaskGetTickCount(), &veiculo->tempo_percurso)) {
+            vTaskDelay(pdMS_TO_TICKS(1000));
         }
+        veiculo->atualizacoes++;
+        registrarEvento(xTaskGetTickCount(), EVENTO_APROXIMACAO, veiculo->id, rede.destino[veiculo->via],
+                        veiculo->movimento, veiculo->velocidade, veiculo->tempo_percurso);
+
+        // Aguarda, bloqueado, percorrer a via e o cruzamento liberá-lo da fila no verde do movimento
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        veiculo->atualizacoes++;
+        registrarEvento(xTaskGetTickCount(), EVENTO_TRAVESSIA, veiculo->id, rede.destino[veiculo->via],
+                        veiculo->movimento, veiculo->velocidade, veiculo->tempo_percurso);
+        vTaskDelay(sortearTravessia(&veiculo->gerador)); // Atravessa o cruzamento, já fora da via
 
         // Seleciona o próximo cruzamento ou finaliza a jornada
-        if (rand() % 2 == 0 && veiculo->movimento != 'F') {
-            veiculo->cruzamento = selecionarProximoCruzamento(veiculo->cruzamento);
-            printf("Veículo %d se dirigindo ao próximo cruzamento %c\n", veiculo->id, veiculo->cruzamento->id);
+        veiculo->atualizacoes++;
+        uint32_t proxima_via = VIA_INEXISTENTE;
+        if (sortearIntervalo(&veiculo->gerador, 2) == 0 && veiculo->movimento != 'F') {
+            proxima_via = selecionarProximaVia(rede.destino[veiculo->via], &veiculo->gerador);
+        }
+        if (proxima_via != VIA_INEXISTENTE) {
+            veiculo->via = proxima_via;
+            registrarEvento(xTaskGetTickCount(), EVENTO_PROXIMO_CRUZAMENTO, veiculo->id, rede.destino[proxima_via],
+                            veiculo->movimento, 0, 0);
         } else {
-            printf("Veículo %d finalizou sua jornada\n", veiculo->id);
-            vTaskDelete(NULL); // Finaliza a tarefa do veículo
+            registrarEvento(xTaskGetTickCount(), EVENTO_FIM_JORNADA, veiculo->id, rede.destino[veiculo->via],
+                            veiculo->movimento, 0, 0);
+
+            // A tarefa não é apagada: fica estacionada até a demanda rearmá-la com outro veículo
+            taskENTER_CRITICAL();
+            estacionados[num_estacionados++] = veiculo->indice;
+            taskEXIT_CRITICAL();
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
         }
+    }
+}
+
+// Função que prepara o veículo da posição 'indice' para uma nova jornada, com
+// o id, o gerador, a via e o movimento de um veículo que acaba de entrar na rede
+static void armarVeiculo(uint32_t indice, int id) {
+    veiculo_t *veiculo = &veiculos[indice];
 
-        // Espera um tempo aleatório antes de gerar o próximo movimento
-        vTaskDelay(pdMS_TO_TICKS(rand() % 3000 + 2000)); // Espera entre 2 e 5 segundos
+    veiculo->id = id;
+    veiculo->indice = indice;
+    iniciarAleatorio(&veiculo->gerador, semente_simulacao, veiculo->id);
+    veiculo->via = sortearIntervalo(&veiculo->gerador, rede.num_vias); // Atribui uma via aleatória
+    veiculo->movimento = sortearMovimento(&veiculo->gerador); // Movimento aleatório
+}
+
+// Função que cria a tarefa de um veículo novo, na próxima posição livre de
+// veiculos[]; devolve false sem posição ou sem memória para a tarefa
+static bool criarVeiculo(int id) {
+    uint32_t indice = num_veiculos;
+
+    if (indice == MAX_VEICULOS) {
+        return false;
     }
+    armarVeiculo(indice, id);
+
+    // Cria a tarefa com pilha reduzida, para caberem muitos veículos na memória
+    tarefas_veiculos[indice] = criarTarefa(vVeiculoTask,
+        "Veiculo Task",
+        PILHA_VEICULO,
+        &veiculos[indice], // Passa o veículo do vetor como parâmetro
+        2);
+    if (tarefas_veiculos[indice] == NULL) {
+        return false;
+    }
+    num_veiculos++;
+    return true;
+}
+
+// Função de tarefa que põe veículos novos na rede, um a cada 3600/demanda
+// segundos. Cada um reaproveita a tarefa de um veículo estacionado; só se não
+// houver nenhum uma tarefa é criada, então com a demanda estável os veículos
+// circulam sem criar nem apagar tarefas.
+void vDemandaTask(void *pvParameters) {
+    TickType_t intervalo = pdMS_TO_TICKS(3600000 / demanda);
+    TickType_t instante = xTaskGetTickCount();
+    int proximo_id = NUM_VEICULOS + 1;
+    uint32_t indice;
+    bool estacionado;
+
+    (void)pvParameters;
+    if (intervalo == 0) {
+        intervalo = 1;
+    }
+
+    while (1) {
+        vTaskDelayUntil(&instante, intervalo);
+
+        taskENTER_CRITICAL();
+        estacionado = num_estacionados > 0;
+        if (estacionado) {
+            indice = estacionados[--num_estacionados];
+        }
+        taskEXIT_CRITICAL();
+
+        if (estacionado) {
+            armarVeiculo(indice, proximo_id);
+            xTaskNotifyGive(tarefas_veiculos[indice]);
+        } else if (!criarVeiculo(proximo_id)) {
+            demanda_recusada++;
+            continue;
+        }
+        proximo_id++;
+    }
+}
+
+// Função de tarefa que encerra a simulação após a duração configurada
+void vSupervisorTask(void *pvParameters) {
+    (void)pvParameters;
+
+    vTaskDelay((TickType_t)duracao_simulacao * configTICK_RATE_HZ);
+    esvaziarEventos(); // O texto dos eventos pendentes sai antes do resumo
+    printf("Simulação encerrada após %d segundos simulados\n", duracao_simulacao);
+    if (demanda > 0) {
+        printf("Demanda: %u tarefas de veículo criadas, %u veículos recusados\n",
+               (unsigned)num_veiculos, (unsigned)demanda_recusada);
+    }
+    if (num_regioes > 0) {
+        encerrarRegioes(); // Os contadores só são lidos com as regiões paradas
+        imprimirResumoRegioes();
+    } else if (num_agentes > 0) {
+        imprimirResumoAgentes();
+    }
+    vTaskEndScheduler();
+}
+
+// Função que reserva as tarefas, pilhas e mutexes que a simulação pode criar:
+// a registradora, a supervisora e as do modo escolhido. Com a demanda, cabem
+// MAX_VEICULOS veículos. Só o modo estático (make ALLOCATION=static) reserva
+// os objetos; sem ele são as threads das tarefas criadas antes do escalonador
+// que já ficam iniciadas.
+static bool reservarSimulacao(int trabalhadores) {
+    uint32_t tarefas = 2;
+    uint32_t veiculos_reservados = 0;
+    uint32_t veiculos_iniciais = 0;
+
+    if (num_regioes > 0) {
+        tarefas++;
+    } else {
+        tarefas += rede.num_cruzamentos;
+        if (num_agentes > 0) {
+            tarefas += trabalhadores > 0 ? (uint32_t)trabalhadores : 0;
+        } else if (demanda > 0) {
+            tarefas++;
+            veiculos_reservados = MAX_VEICULOS;
+            veiculos_iniciais = NUM_VEICULOS;
+        } else {
+            veiculos_reservados = NUM_VEICULOS;
+            veiculos_iniciais = NUM_VEICULOS;
+        }
+    }
+    reservarThreads(tarefas, 0);
+    reservarThreads(veiculos_iniciais, PILHA_VEICULO);
+    return reservarObjetos(tarefas + veiculos_reservados,
+                           (size_t)tarefas * PILHA_TAREFA + (size_t)veiculos_reservados * PILHA_VEICULO,
+                           1); // O mutex da escrita dos eventos em texto
 }
 
 // Função principal
-int main(void) {
-
-    veiculo_t veiculos[NUM_VEICULOS]; // Cria um vetor de veículos
-
-    srand(time(NULL)); // Inicializa o gerador de números aleatórios
-
-    criarCruzamentos(); // Cria os cruzamentos e as tarefas
-
-    // Cria veículos
-    for (int i = 0; i < NUM_VEICULOS; i++) {
-        veiculos[i].id = i + 1; // ID do veículo começa em 1
-        veiculos[i].cruzamento = &cruzamentos[rand() % NUM_CRUZAMENTOS]; // Atribui um cruzamento aleatório
-        veiculos[i].movimento = (rand() % 3) == 0 ? 'L' : (rand() % 3) == 1 ? 'R' : 'F'; // Movimento aleatório
-    
-        // Cria a tarefa passando o veículo do array como parâmetro
-        xTaskCreate(vVeiculoTask, 
-            "Veiculo Task", 
-            configMINIMAL_STACK_SIZE, 
-            &veiculos[i], // Passa o veículo como parâmetro
-            2, 
-            NULL);
+int main(int argc, char *argv[]) {
+
+    int opcao;
+    int trabalhadores = TRABALHADORES_AGENTES;
+    const char *arquivo_rede = NULL;
+    const char *arquivo_eventos = NULL;
+    bool texto = false;
+    bool metricas = false;
+    bool semente_definida = false;
+    uint64_t semente = 0;
+
+    // Lê as opções de linha de comando
+    while ((opcao = getopt(argc, argv, "t:a:w:p:r:e:vms:f:d:")) != -1) {
+        switch (opcao) {
+            case 't':
+                duracao_simulacao = atoi(optarg);
+                break;
+            case 'a':
+                num_agentes = strtoul(optarg, NULL, 10);
+                break;
+            case 'w':
+                trabalhadores = atoi(optarg);
+                break;
+            case 'p':
+                num_regioes = atoi(optarg);
+                break;
+            case 'r':
+                arquivo_rede = optarg;
+                break;
+            case 'e':
+                arquivo_eventos = optarg;
+                break;
+            case 'v':
+                texto = true;
+                break;
+            case 'm':
+                metricas = true;
+                break;
+            case 's':
+                semente = strtoull(optarg, NULL, 10);
+                semente_definida = true;
+                break;
+            case 'f':
+                fluxo_saturacao = strtoul(optarg, NULL, 10);
+                break;
+            case 'd':
+                demanda = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                fprintf(stderr, "Uso: %s [-t segundos] [-a veículos] [-w trabalhadores] [-p regiões] [-r rede] [-e eventos] [-v] [-m] [-s semente] [-f veículos/hora] [-d veículos/hora]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (fluxo_saturacao == 0) {
+        fprintf(stderr, "Fluxo de saturação inválido\n");
+        return 1;
+    }
+
+    // O modo paralelo avança agentes fora do FreeRTOS, sem a tarefa registradora do texto
+    if (num_regioes > 0 && (num_agentes == 0 || texto)) {
+        fprintf(stderr, "-p exige -a e não aceita -v\n");
+        return 1;
     }
 
+    // A demanda cria veículos do modo de tarefas
+    if (demanda > 0 && num_agentes > 0) {
+        fprintf(stderr, "-d não se aplica ao modo de agentes\n");
+        return 1;
+    }
+
+    // Sem -s a semente vem do relógio; ela é informada para a execução poder ser repetida
+    if (!semente_definida) {
+        semente = (uint64_t)time(NULL);
+        fprintf(stderr, "Semente: %llu\n", (unsigned long long)semente);
+    }
+    semente_simulacao = semente;
+
+    // Carrega a rede viária do arquivo ou usa a grade 2x2 padrão
+    if (arquivo_rede != NULL) {
+        if (!carregarRede(arquivo_rede)) {
+            return 1;
+        }
+    } else if (!criarRedePadrao()) {
+        fprintf(stderr, "Não foi possível criar a rede padrão\n");
+        return 1;
+    }
+    if (!criarVias()) {
+        fprintf(stderr, "Não foi possível criar o estado das %u vias\n", (unsigned)rede.num_vias);
+        return 1;
+    }
+
+    iniciarReserva();
+    if (!reservarSimulacao(trabalhadores)) {
+        fprintf(stderr, "Não foi possível reservar as tarefas da simulação\n");
+        return 1;
+    }
+
+    // Eventos binários em -e; o texto sai com -v ou, no modo de tarefas, quando não há -e
+    if (!iniciarEventos(arquivo_eventos, texto || (arquivo_eventos == NULL && num_agentes == 0))) {
+        return 1;
+    }
+
+    iniciarPartida();
+    if (num_regioes > 0) {
+        // Modo paralelo: as regiões calculam as fases e não usam as tarefas dos cruzamentos
+        if (!criarRegioes(num_agentes, num_regioes, trabalhadores, semente)) {
+            fprintf(stderr, "Não foi possível criar %d regiões com %u agentes\n", num_regioes, (unsigned)num_agentes);
+            return 1;
+        }
+    } else if (!criarCruzamentos()) { // Cria os cruzamentos e as tarefas
+        fprintf(stderr, "Não foi possível criar %u cruzamentos\n", (unsigned)rede.num_cruzamentos);
+        return 1;
+    } else if (num_agentes > 0) {
+        // Modo de agentes: veículos são registros avançados pelas trabalhadoras
+        if (!criarAgentes(num_agentes, trabalhadores, semente)) {
+            fprintf(stderr, "Não foi possível criar %u agentes\n", (unsigned)num_agentes);
+            return 1;
+        }
+    } else {
+        for (int i = 0; i < NUM_VEICULOS; i++) {
+            if (!criarVeiculo(i + 1)) { // ID do veículo começa em 1
+                fprintf(stderr, "Não foi possível criar o veículo %d\n", i + 1);
+                return 1;
+            }
+        }
+
+        // Com demanda, novos veículos entram na rede ao longo da simulação
+        if (demanda > 0) {
+            criarTarefa(vDemandaTask,
+                "Demanda",
+                0,
+                NULL,
+                2);
+        }
+    }
+
+    // Cria a tarefa que encerra a simulação, se houver duração definida
+    if (duracao_simulacao > 0) {
+        criarTarefa(vSupervisorTask,
+            "Supervisor",
+            0,
+            NULL,
+            3);
+    }
+
+    iniciarMetricas();
     vTaskStartScheduler(); // Inicia o agendador FreeRTOS
 
-    return 0; // Este ponto nunca deve ser alcançado
+    // Só chega aqui quando o supervisor encerra o agendador
+    finalizarEventos();
+    if (metricas) {
+        uint64_t atualizacoes = totalAtualizacoesAgentes() + totalAtualizacoesRegioes();
+        if (num_agentes == 0) {
+            for (uint32_t i = 0; i < num_veiculos; i++) {
+                atualizacoes += veiculos[i].atualizacoes;
+            }
+        }
+        imprimirMetricas(atualizacoes);
+    }
+
+#if configSUPPORT_STATIC_ALLOCATION == 1
+    // No modo estático a simulação em andamento não aloca no heap do FreeRTOS
+    if (ulAlocacoesAposPartida > 0) {
+        fprintf(stderr, "%lu alocações no heap do FreeRTOS depois do início do agendador\n", ulAlocacoesAposPartida);
+        return 1;
+    }
+#endif
+    return 0;
 }
\ No newline at end of file
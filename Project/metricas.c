@@ -0,0 +1,54 @@
+#include <FreeRTOS.h>
+#include <task.h>
+#include <stdio.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "metricas.h"
+
+void *pvTarefaAnterior = NULL;      // Tarefa em execução antes de vTaskSwitchContext()
+unsigned long ulTrocasDeContexto = 0;
+
+static struct timespec inicio_reserva, inicio_partida, inicio;
+
+// Segundos de 'de' até 'ate'
+static double segundosEntre(const struct timespec *de, const struct timespec *ate) {
+    return (double)(ate->tv_sec - de->tv_sec) + (double)(ate->tv_nsec - de->tv_nsec) / 1e9;
+}
+
+// Marca o início da reserva das tarefas, feita antes da partida
+void iniciarReserva(void) {
+    clock_gettime(CLOCK_MONOTONIC, &inicio_reserva);
+}
+
+// Marca o início da partida: a criação das tarefas e estruturas da simulação
+void iniciarPartida(void) {
+    clock_gettime(CLOCK_MONOTONIC, &inicio_partida);
+}
+
+// Marca o início da execução; chamada logo antes de iniciar o escalonador
+void iniciarMetricas(void) {
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+}
+
+// Imprime as métricas em uma linha "metricas: chave=valor ...", com taxas por
+// segundo de relógio. Chamada depois que o escalonador termina.
+void imprimirMetricas(uint64_t atualizacoes) {
+    struct timespec fim;
+    struct rusage uso;
+    double real, simulado;
+
+    clock_gettime(CLOCK_MONOTONIC, &fim);
+    getrusage(RUSAGE_SELF, &uso);
+    real = segundosEntre(&inicio, &fim);
+    simulado = (double)xTaskGetTickCount() / configTICK_RATE_HZ;
+    if (real <= 0) {
+        real = 1e-9;
+    }
+
+    printf("metricas: simulado_s=%.3f real_s=%.6f reserva_s=%.6f partida_s=%.6f simulado_por_real=%.3f trocas_contexto=%lu "
+           "trocas_por_s=%.1f atualizacoes=%llu atualizacoes_por_s=%.1f pico_rss_kb=%ld\n",
+           simulado, real, segundosEntre(&inicio_reserva, &inicio_partida), segundosEntre(&inicio_partida, &inicio), simulado / real, ulTrocasDeContexto,
+           ulTrocasDeContexto / real, (unsigned long long)atualizacoes, atualizacoes / real,
+           uso.ru_maxrss);
+}
@@ -0,0 +1,18 @@
+#ifndef METRICAS_H
+#define METRICAS_H
+
+// Métricas de desempenho de uma execução (opção -m, usada por make bench).
+// As trocas de contexto são contadas pelas macros de trace do kernel
+// definidas em FreeRTOSConfig.h.
+
+#include <stdint.h>
+
+extern void *pvTarefaAnterior;
+extern unsigned long ulTrocasDeContexto;
+
+void iniciarReserva(void);
+void iniciarPartida(void);
+void iniciarMetricas(void);
+void imprimirMetricas(uint64_t atualizacoes);
+
+#endif
@@ -0,0 +1,301 @@
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+#include <semphr.h>
+#include <event_groups.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "metricas.h"
+
+// Microbenchmarks das primitivas do kernel no porte em uso: mede cada
+// operação (ou ida e volta entre duas tarefas) com o relógio monotônico e
+// imprime ns/op com percentis, para escolher a primitiva mais barata.
+
+#define ITERACOES_PADRAO 10000
+#define PRIORIDADE_MEDIDORA 2 // A parceira tem a mesma prioridade: cada ida e volta são duas trocas de contexto
+#define HEAP_BLOCOS_VIVOS 2048   // Blocos alocados no heap durante o benchmark do heap
+#define HEAP_TAMANHO_MEDIDO 160  // bytes de cada alocação medida, perto do tamanho de um TCB
+
+typedef struct {
+    const char *nome;
+    void (*medir)(uint64_t *amostras, int iteracoes);
+} microbench_t;
+
+void vAssertCalled(unsigned long ulLine, const char * const pcFileName);
+void vApplicationIdleHook(void);
+
+static int iteracoes = ITERACOES_PADRAO;
+static volatile bool parceira_termina = false;
+
+// Objetos compartilhados entre a medidora e a parceira do benchmark atual
+static SemaphoreHandle_t semaforo_ida, semaforo_volta;
+static QueueHandle_t fila_ida, fila_volta;
+static TaskHandle_t medidora, parceira;
+static EventGroupHandle_t grupo;
+
+#define BIT_IDA (1 << 0)
+#define BIT_VOLTA (1 << 1)
+
+void vAssertCalled(unsigned long ulLine, const char * const pcFileName) {
+    fprintf(stderr, "Falha de asserção em %s:%lu\n", pcFileName, ulLine);
+    abort();
+}
+
+void vApplicationIdleHook(void) {
+    vPortWaitForTick();
+}
+
+static uint64_t agoraNs(void) {
+    struct timespec agora;
+
+    clock_gettime(CLOCK_MONOTONIC, &agora);
+    return (uint64_t)agora.tv_sec * 1000000000ull + (uint64_t)agora.tv_nsec;
+}
+
+// Cria a tarefa parceira na mesma prioridade da medidora
+static void criarParceira(TaskFunction_t funcao) {
+    parceira_termina = false;
+    xTaskCreate(funcao, "Parceira", configMINIMAL_STACK_SIZE, NULL, PRIORIDADE_MEDIDORA, &parceira);
+}
+
+// Semáforo: take e give de um mutex livre, sem troca de contexto
+static void medirSemaforo(uint64_t *amostras, int n) {
+    SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+
+    for (int i = 0; i < n; i++) {
+        uint64_t inicio = agoraNs();
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        xSemaphoreGive(mutex);
+        amostras[i] = agoraNs() - inicio;
+    }
+    vSemaphoreDelete(mutex);
+}
+
+static void vParceiraSemaforoTask(void *pvParameters) {
+    (void)pvParameters;
+    for (int i = 0; i < iteracoes; i++) {
+        xSemaphoreTake(semaforo_ida, portMAX_DELAY);
+        xSemaphoreGive(semaforo_volta);
+    }
+    vTaskDelete(NULL);
+}
+
+// Semáforo ida e volta: give para a parceira e take da resposta
+static void medirSemaforoIdaVolta(uint64_t *amostras, int n) {
+    semaforo_ida = xSemaphoreCreateBinary();
+    semaforo_volta = xSemaphoreCreateBinary();
+    criarParceira(vParceiraSemaforoTask);
+
+    for (int i = 0; i < n; i++) {
+        uint64_t inicio = agoraNs();
+        xSemaphoreGive(semaforo_ida);
+        xSemaphoreTake(semaforo_volta, portMAX_DELAY);
+        amostras[i] = agoraNs() - inicio;
+    }
+    vTaskDelay(1); // Deixa a parceira e a tarefa ociosa terminarem
+    vSemaphoreDelete(semaforo_ida);
+    vSemaphoreDelete(semaforo_volta);
+}
+
+static void vParceiraCedeTask(void *pvParameters) {
+    (void)pvParameters;
+    while (!parceira_termina) {
+        vTaskDelay(0);
+    }
+    vTaskDelete(NULL);
+}
+
+// vTaskDelay(0) com outra tarefa pronta na mesma prioridade: cede a vez e volta
+static void medirCederVez(uint64_t *amostras, int n) {
+    criarParceira(vParceiraCedeTask);
+
+    for (int i = 0; i < n; i++) {
+        uint64_t inicio = agoraNs();
+        vTaskDelay(0);
+        amostras[i] = agoraNs() - inicio;
+    }
+    parceira_termina = true;
+    vTaskDelay(1);
+}
+
+static void vParceiraFilaTask(void *pvParameters) {
+    uint32_t valor;
+
+    (void)pvParameters;
+    for (int i = 0; i < iteracoes; i++) {
+        xQueueReceive(fila_ida, &valor, portMAX_DELAY);
+        xQueueSend(fila_volta, &valor, portMAX_DELAY);
+    }
+    vTaskDelete(NULL);
+}
+
+// Fila ida e volta: xQueueSend para a parceira e xQueueReceive da resposta
+static void medirFila(uint64_t *amostras, int n) {
+    uint32_t valor = 0;
+
+    fila_ida = xQueueCreate(1, sizeof(uint32_t));
+    fila_volta = xQueueCreate(1, sizeof(uint32_t));
+    criarParceira(vParceiraFilaTask);
+
+    for (int i = 0; i < n; i++) {
+        uint64_t inicio = agoraNs();
+        xQueueSend(fila_ida, &valor, portMAX_DELAY);
+        xQueueReceive(fila_volta, &valor, portMAX_DELAY);
+        amostras[i] = agoraNs() - inicio;
+    }
+    vTaskDelay(1);
+    vQueueDelete(fila_ida);
+    vQueueDelete(fila_volta);
+}
+
+static void vParceiraNotificacaoTask(void *pvParameters) {
+    (void)pvParameters;
+    for (int i = 0; i < iteracoes; i++) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        xTaskNotifyGive(medidora);
+    }
+    vTaskDelete(NULL);
+}
+
+// Notificação ida e volta: xTaskNotifyGive para a parceira e ulTaskNotifyTake da resposta
+static void medirNotificacao(uint64_t *amostras, int n) {
+    criarParceira(vParceiraNotificacaoTask);
+
+    for (int i = 0; i < n; i++) {
+        uint64_t inicio = agoraNs();
+        xTaskNotifyGive(parceira);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        amostras[i] = agoraNs() - inicio;
+    }
+    vTaskDelay(1);
+}
+
+static void vParceiraGrupoTask(void *pvParameters) {
+    (void)pvParameters;
+    for (int i = 0; i < iteracoes; i++) {
+        xEventGroupWaitBits(grupo, BIT_IDA, pdTRUE, pdFALSE, portMAX_DELAY);
+        xEventGroupSetBits(grupo, BIT_VOLTA);
+    }
+    vTaskDelete(NULL);
+}
+
+// Grupo de eventos ida e volta: xEventGroupSetBits para a parceira e xEventGroupWaitBits da resposta
+static void medirGrupoEventos(uint64_t *amostras, int n) {
+    grupo = xEventGroupCreate();
+    criarParceira(vParceiraGrupoTask);
+
+    for (int i = 0; i < n; i++) {
+        uint64_t inicio = agoraNs();
+        xEventGroupSetBits(grupo, BIT_IDA);
+        xEventGroupWaitBits(grupo, BIT_VOLTA, pdTRUE, pdFALSE, portMAX_DELAY);
+        amostras[i] = agoraNs() - inicio;
+    }
+    vTaskDelay(1);
+    vEventGroupDelete(grupo);
+}
+
+// Heap: pvPortMalloc e vPortFree do tamanho de um TCB, com o heap já
+// fragmentado por blocos vivos de vários tamanhos, como na criação de veículos
+static void medirHeap(uint64_t *amostras, int n) {
+    void *vivos[HEAP_BLOCOS_VIVOS];
+
+    for (int i = 0; i < HEAP_BLOCOS_VIVOS; i++) {
+        vivos[i] = pvPortMalloc(16 + (i * 40) % 1024);
+    }
+    for (int i = 0; i < HEAP_BLOCOS_VIVOS; i += 2) {
+        vPortFree(vivos[i]);
+    }
+    for (int i = 0; i < n; i++) {
+        uint64_t inicio = agoraNs();
+        vPortFree(pvPortMalloc(HEAP_TAMANHO_MEDIDO));
+        amostras[i] = agoraNs() - inicio;
+    }
+    for (int i = 1; i < HEAP_BLOCOS_VIVOS; i += 2) {
+        vPortFree(vivos[i]);
+    }
+}
+
+static const microbench_t microbenchs[] = {
+    { "semaforo take+give", medirSemaforo },
+    { "semaforo ida/volta", medirSemaforoIdaVolta },
+    { "vTaskDelay(0)", medirCederVez },
+    { "fila ida/volta", medirFila },
+    { "notificacao ida/volta", medirNotificacao },
+    { "grupo ida/volta", medirGrupoEventos },
+    { "heap malloc+free", medirHeap },
+};
+
+static int compararAmostras(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+// Percentil 'p' (0 a 100) das amostras já ordenadas
+static uint64_t percentil(const uint64_t *amostras, int n, int p) {
+    return amostras[(int)((int64_t)(n - 1) * p / 100)];
+}
+
+// Tarefa medidora: executa os benchmarks em sequência e encerra o escalonador
+static void vMedidoraTask(void *pvParameters) {
+    uint64_t *amostras = pvParameters;
+
+    printf("%-22s %10s %8s %8s %8s %8s %10s %9s\n",
+           "primitiva", "média ns", "mín", "p50", "p90", "p99", "máx", "trocas/op");
+    for (size_t b = 0; b < sizeof(microbenchs) / sizeof(microbenchs[0]); b++) {
+        unsigned long trocas = ulTrocasDeContexto;
+        uint64_t soma = 0;
+
+        microbenchs[b].medir(amostras, iteracoes);
+        trocas = ulTrocasDeContexto - trocas;
+
+        qsort(amostras, iteracoes, sizeof(*amostras), compararAmostras);
+        for (int i = 0; i < iteracoes; i++) {
+            soma += amostras[i];
+        }
+        printf("%-22s %10.1f %8llu %8llu %8llu %8llu %10llu %9.2f\n", microbenchs[b].nome,
+               (double)soma / iteracoes,
+               (unsigned long long)amostras[0],
+               (unsigned long long)percentil(amostras, iteracoes, 50),
+               (unsigned long long)percentil(amostras, iteracoes, 90),
+               (unsigned long long)percentil(amostras, iteracoes, 99),
+               (unsigned long long)amostras[iteracoes - 1],
+               (double)trocas / iteracoes);
+    }
+    vTaskEndScheduler();
+}
+
+int main(int argc, char *argv[]) {
+    uint64_t *amostras;
+    int opcao;
+
+    while ((opcao = getopt(argc, argv, "n:")) != -1) {
+        switch (opcao) {
+            case 'n':
+                iteracoes = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "Uso: %s [-n iterações]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (iteracoes <= 0) {
+        fprintf(stderr, "Número de iterações inválido\n");
+        return 1;
+    }
+
+    amostras = malloc(iteracoes * sizeof(*amostras));
+    if (amostras == NULL) {
+        fprintf(stderr, "Não foi possível alocar %d amostras\n", iteracoes);
+        return 1;
+    }
+    xTaskCreate(vMedidoraTask, "Medidora", configMINIMAL_STACK_SIZE, amostras, PRIORIDADE_MEDIDORA, &medidora);
+    vTaskStartScheduler();
+    free(amostras);
+    return 0;
+}
@@ -0,0 +1,402 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "rede.h"
+
+// A rede é carregada antes do agendador iniciar, por isso usa malloc
+// diretamente; assim este arquivo também compõe a ferramenta converter_rede
+
+#define TAMANHO_LINHA 256
+#define ALINHAMENTO_BINARIO 8
+
+// Via como aparece no arquivo texto, antes de agrupada por cruzamento de origem
+typedef struct {
+    uint32_t origem;
+    uint32_t destino;
+    float comprimento;
+    float velocidade_maxima;
+} via_lida_t;
+
+// Posição de cada vetor no arquivo binário
+typedef struct {
+    uint64_t inicio_vias;
+    uint64_t destino;
+    uint64_t comprimento;
+    uint64_t velocidade_maxima;
+    uint64_t inicio_nome;
+    uint64_t nomes;
+    uint64_t tamanho_total;
+} secoes_rede_t;
+
+rede_t rede;
+
+// Grade 2x2 usada quando nenhum arquivo é informado:
+//   A --500m-- B
+//   |          |
+//   C --500m-- D
+// As vias que chegam a A e B (Norte-Sul) têm 60 km/h, as que chegam a C e D (Leste-Oeste), 50 km/h
+static const char nomes_padrao[] = "A\0B\0C\0D";
+static const uint32_t inicio_nome_padrao[] = { 0, 2, 4, 6 };
+static const via_lida_t vias_padrao[] = {
+    { 0, 1, 500, 60 }, { 0, 2, 500, 50 },   // A -> B, A -> C
+    { 1, 0, 500, 60 }, { 1, 3, 500, 50 },   // B -> A, B -> D
+    { 2, 0, 500, 60 }, { 2, 3, 500, 50 },   // C -> A, C -> D
+    { 3, 1, 500, 60 }, { 3, 2, 500, 50 },   // D -> B, D -> C
+};
+
+// Monta os vetores CSR agrupando as vias pelo cruzamento de origem
+static bool construirRede(uint32_t num_cruzamentos, const char *nomes, const uint32_t *inicio_nome,
+                          uint32_t tamanho_nomes, uint32_t num_vias, const via_lida_t *vias) {
+    uint32_t *inicio = malloc((num_cruzamentos + 1) * sizeof(*inicio));
+    uint32_t *destino = malloc(num_vias * sizeof(*destino));
+    float *comprimento = malloc(num_vias * sizeof(*comprimento));
+    float *velocidade_maxima = malloc(num_vias * sizeof(*velocidade_maxima));
+
+    if (!inicio || !destino || !comprimento || !velocidade_maxima) {
+        free(inicio);
+        free(destino);
+        free(comprimento);
+        free(velocidade_maxima);
+        return false;
+    }
+
+    // Conta as vias de saída de cada cruzamento e acumula as posições iniciais
+    memset(inicio, 0, (num_cruzamentos + 1) * sizeof(*inicio));
+    for (uint32_t v = 0; v < num_vias; v++) {
+        inicio[vias[v].origem + 1]++;
+    }
+    for (uint32_t c = 0; c < num_cruzamentos; c++) {
+        inicio[c + 1] += inicio[c];
+    }
+
+    // Distribui as vias usando inicio[c] como cursor do cruzamento c, depois desfaz o avanço
+    for (uint32_t v = 0; v < num_vias; v++) {
+        uint32_t posicao = inicio[vias[v].origem]++;
+        destino[posicao] = vias[v].destino;
+        comprimento[posicao] = vias[v].comprimento;
+        velocidade_maxima[posicao] = vias[v].velocidade_maxima;
+    }
+    for (uint32_t c = num_cruzamentos; c > 0; c--) {
+        inicio[c] = inicio[c - 1];
+    }
+    inicio[0] = 0;
+
+    rede.num_cruzamentos = num_cruzamentos;
+    rede.num_vias = num_vias;
+    rede.inicio_vias = inicio;
+    rede.destino = destino;
+    rede.comprimento = comprimento;
+    rede.velocidade_maxima = velocidade_maxima;
+    rede.inicio_nome = inicio_nome;
+    rede.nomes = nomes;
+    rede.tamanho_nomes = tamanho_nomes;
+    return true;
+}
+
+// Cria a grade 2x2 padrão
+bool criarRedePadrao(void) {
+    return construirRede(sizeof(inicio_nome_padrao) / sizeof(inicio_nome_padrao[0]), nomes_padrao,
+                         inicio_nome_padrao, sizeof(nomes_padrao),
+                         sizeof(vias_padrao) / sizeof(vias_padrao[0]), vias_padrao);
+}
+
+// Lê a rede em texto, com uma declaração por linha:
+//   cruzamento <nome>
+//   via <origem> <destino> <comprimento em metros> <velocidade máxima em km/h>
+// Origem e destino são os índices dos cruzamentos, na ordem em que foram
+// declarados (a partir de 0). Linhas vazias e iniciadas por '#' são ignoradas.
+static bool carregarRedeTexto(FILE *entrada, const char *arquivo) {
+    char linha[TAMANHO_LINHA];
+    char nome[TAMANHO_LINHA];
+    char *nomes = NULL;
+    uint32_t *inicio_nome = NULL;
+    via_lida_t *vias = NULL;
+    uint32_t tamanho_nomes = 0, capacidade_nomes = 0;
+    uint32_t num_cruzamentos = 0, capacidade_cruzamentos = 0;
+    uint32_t num_vias = 0, capacidade_vias = 0;
+    uint32_t num_linha = 0;
+    bool sucesso = true;
+
+    while (sucesso && fgets(linha, sizeof(linha), entrada) != NULL) {
+        char *conteudo = linha + strspn(linha, " \t\r\n");
+        unsigned long origem, destino;
+        float comprimento, velocidade;
+
+        num_linha++;
+        if (*conteudo == '\0' || *conteudo == '#') {
+            continue;
+        }
+
+        if (sscanf(conteudo, "cruzamento %255s", nome) == 1) {
+            uint32_t tamanho = strlen(nome) + 1;
+
+            // Com falha no realloc o vetor antigo continua válido e é liberado no fim
+            if (num_cruzamentos == capacidade_cruzamentos) {
+                uint32_t capacidade = capacidade_cruzamentos ? capacidade_cruzamentos * 2 : 64;
+                uint32_t *novo = realloc(inicio_nome, capacidade * sizeof(*novo));
+
+                if (novo == NULL) {
+                    fprintf(stderr, "Memória insuficiente para a rede %s\n", arquivo);
+                    sucesso = false;
+                    break;
+                }
+                inicio_nome = novo;
+                capacidade_cruzamentos = capacidade;
+            }
+            if (tamanho_nomes + tamanho > capacidade_nomes) {
+                uint32_t capacidade = capacidade_nomes ? capacidade_nomes * 2 : 1024;
+                char *novo = realloc(nomes, capacidade);
+
+                if (novo == NULL) {
+                    fprintf(stderr, "Memória insuficiente para a rede %s\n", arquivo);
+                    sucesso = false;
+                    break;
+                }
+                nomes = novo;
+                capacidade_nomes = capacidade;
+            }
+            inicio_nome[num_cruzamentos++] = tamanho_nomes;
+            memcpy(nomes + tamanho_nomes, nome, tamanho);
+            tamanho_nomes += tamanho;
+        } else if (sscanf(conteudo, "via %lu %lu %f %f", &origem, &destino, &comprimento, &velocidade) == 4) {
+            if (origem >= num_cruzamentos || destino >= num_cruzamentos) {
+                fprintf(stderr, "%s:%u: via entre cruzamentos não declarados\n", arquivo, (unsigned)num_linha);
+                sucesso = false;
+                break;
+            }
+            if (comprimento <= 0 || velocidade <= 0) {
+                fprintf(stderr, "%s:%u: comprimento e velocidade devem ser positivos\n", arquivo, (unsigned)num_linha);
+                sucesso = false;
+                break;
+            }
+            if (num_vias == capacidade_vias) {
+                uint32_t capacidade = capacidade_vias ? capacidade_vias * 2 : 256;
+                via_lida_t *novo = realloc(vias, capacidade * sizeof(*novo));
+
+                if (novo == NULL) {
+                    fprintf(stderr, "Memória insuficiente para a rede %s\n", arquivo);
+                    sucesso = false;
+                    break;
+                }
+                vias = novo;
+                capacidade_vias = capacidade;
+            }
+            vias[num_vias].origem = (uint32_t)origem;
+            vias[num_vias].destino = (uint32_t)destino;
+            vias[num_vias].comprimento = comprimento;
+            vias[num_vias].velocidade_maxima = velocidade;
+            num_vias++;
+        } else {
+            fprintf(stderr, "%s:%u: linha inválida\n", arquivo, (unsigned)num_linha);
+            sucesso = false;
+        }
+    }
+
+    if (sucesso && num_vias == 0) {
+        fprintf(stderr, "A rede %s não tem vias\n", arquivo);
+        sucesso = false;
+    }
+
+    // Os nomes ficam com a rede; as vias lidas são descartadas depois de agrupadas
+    if (sucesso && !construirRede(num_cruzamentos, nomes, inicio_nome, tamanho_nomes, num_vias, vias)) {
+        fprintf(stderr, "Memória insuficiente para a rede %s\n", arquivo);
+        sucesso = false;
+    }
+    if (!sucesso) {
+        free(nomes);
+        free(inicio_nome);
+    }
+    free(vias);
+    return sucesso;
+}
+
+static uint64_t alinhar(uint64_t posicao) {
+    return (posicao + ALINHAMENTO_BINARIO - 1) & ~(uint64_t)(ALINHAMENTO_BINARIO - 1);
+}
+
+// Calcula onde fica cada vetor da rede no arquivo binário
+static secoes_rede_t calcularSecoes(uint32_t num_cruzamentos, uint32_t num_vias, uint32_t tamanho_nomes) {
+    secoes_rede_t secoes;
+
+    secoes.inicio_vias = alinhar(sizeof(cabecalho_rede_t));
+    secoes.destino = alinhar(secoes.inicio_vias + ((uint64_t)num_cruzamentos + 1) * sizeof(uint32_t));
+    secoes.comprimento = alinhar(secoes.destino + (uint64_t)num_vias * sizeof(uint32_t));
+    secoes.velocidade_maxima = alinhar(secoes.comprimento + (uint64_t)num_vias * sizeof(float));
+    secoes.inicio_nome = alinhar(secoes.velocidade_maxima + (uint64_t)num_vias * sizeof(float));
+    secoes.nomes = alinhar(secoes.inicio_nome + (uint64_t)num_cruzamentos * sizeof(uint32_t));
+    secoes.tamanho_total = secoes.nomes + tamanho_nomes;
+    return secoes;
+}
+
+// Confere os índices da rede mapeada, para que um arquivo corrompido não leve a acessos fora dos vetores
+static bool validarRede(void) {
+    if (rede.num_vias == 0 || rede.inicio_vias[0] != 0 ||
+        rede.inicio_vias[rede.num_cruzamentos] != rede.num_vias ||
+        rede.tamanho_nomes == 0 || rede.nomes[rede.tamanho_nomes - 1] != '\0') {
+        return false;
+    }
+    for (uint32_t c = 0; c < rede.num_cruzamentos; c++) {
+        if (rede.inicio_vias[c] > rede.inicio_vias[c + 1] || rede.inicio_nome[c] >= rede.tamanho_nomes) {
+            return false;
+        }
+    }
+    for (uint32_t v = 0; v < rede.num_vias; v++) {
+        if (rede.destino[v] >= rede.num_cruzamentos ||
+            !(rede.comprimento[v] > 0) || !(rede.velocidade_maxima[v] > 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Mapeia a rede binária e aponta os vetores da rede direto para o arquivo
+static bool carregarRedeBinaria(const char *arquivo) {
+    int descritor = open(arquivo, O_RDONLY);
+    struct stat informacoes;
+    const uint8_t *mapa;
+    const cabecalho_rede_t *cabecalho;
+    secoes_rede_t secoes;
+
+    if (descritor < 0 || fstat(descritor, &informacoes) != 0) {
+        fprintf(stderr, "Não foi possível abrir a rede %s\n", arquivo);
+        if (descritor >= 0) {
+            close(descritor);
+        }
+        return false;
+    }
+    if ((uint64_t)informacoes.st_size < sizeof(cabecalho_rede_t)) {
+        fprintf(stderr, "%s: rede binária truncada\n", arquivo);
+        close(descritor);
+        return false;
+    }
+
+    mapa = mmap(NULL, informacoes.st_size, PROT_READ, MAP_PRIVATE, descritor, 0);
+    close(descritor);
+    if (mapa == MAP_FAILED) {
+        fprintf(stderr, "Não foi possível mapear a rede %s\n", arquivo);
+        return false;
+    }
+
+    cabecalho = (const cabecalho_rede_t *)mapa;
+    if (cabecalho->versao != REDE_BINARIA_VERSAO) {
+        fprintf(stderr, "%s: versão %u da rede binária não suportada (esperada %u)\n",
+                arquivo, (unsigned)cabecalho->versao, (unsigned)REDE_BINARIA_VERSAO);
+        munmap((void *)mapa, informacoes.st_size);
+        return false;
+    }
+    secoes = calcularSecoes(cabecalho->num_cruzamentos, cabecalho->num_vias, cabecalho->tamanho_nomes);
+    if (secoes.tamanho_total > (uint64_t)informacoes.st_size) {
+        fprintf(stderr, "%s: rede binária truncada\n", arquivo);
+        munmap((void *)mapa, informacoes.st_size);
+        return false;
+    }
+
+    rede.num_cruzamentos = cabecalho->num_cruzamentos;
+    rede.num_vias = cabecalho->num_vias;
+    rede.inicio_vias = (const uint32_t *)(mapa + secoes.inicio_vias);
+    rede.destino = (const uint32_t *)(mapa + secoes.destino);
+    rede.comprimento = (const float *)(mapa + secoes.comprimento);
+    rede.velocidade_maxima = (const float *)(mapa + secoes.velocidade_maxima);
+    rede.inicio_nome = (const uint32_t *)(mapa + secoes.inicio_nome);
+    rede.nomes = (const char *)(mapa + secoes.nomes);
+    rede.tamanho_nomes = cabecalho->tamanho_nomes;
+
+    if (!validarRede()) {
+        fprintf(stderr, "%s: rede binária inconsistente\n", arquivo);
+        munmap((void *)mapa, informacoes.st_size);
+        return false;
+    }
+    return true;
+}
+
+// Carrega a rede de um arquivo, binário (gerado por converter_rede) ou texto
+bool carregarRede(const char *arquivo) {
+    FILE *entrada = fopen(arquivo, "r");
+    char magica[sizeof(((cabecalho_rede_t *)0)->magica)];
+    bool sucesso;
+
+    if (entrada == NULL) {
+        fprintf(stderr, "Não foi possível abrir a rede %s\n", arquivo);
+        return false;
+    }
+
+    if (fread(magica, 1, sizeof(magica), entrada) == sizeof(magica) &&
+        memcmp(magica, REDE_BINARIA_MAGICA, sizeof(magica)) == 0) {
+        fclose(entrada);
+        return carregarRedeBinaria(arquivo);
+    }
+
+    rewind(entrada);
+    sucesso = carregarRedeTexto(entrada, arquivo);
+    fclose(entrada);
+    return sucesso;
+}
+
+// Escreve 'tamanho' bytes de 'dados' na posição 'secao', preenchendo com zeros o espaço até ela
+static bool escreverSecao(FILE *saida, uint64_t *posicao, uint64_t secao, const void *dados, size_t tamanho) {
+    static const char zeros[ALINHAMENTO_BINARIO];
+
+    if (fwrite(zeros, 1, secao - *posicao, saida) != secao - *posicao ||
+        fwrite(dados, 1, tamanho, saida) != tamanho) {
+        return false;
+    }
+    *posicao = secao + tamanho;
+    return true;
+}
+
+// Grava a rede carregada no formato binário
+bool salvarRedeBinaria(const char *arquivo) {
+    FILE *saida = fopen(arquivo, "wb");
+    cabecalho_rede_t cabecalho;
+    secoes_rede_t secoes = calcularSecoes(rede.num_cruzamentos, rede.num_vias, rede.tamanho_nomes);
+    uint64_t posicao = 0;
+    bool sucesso;
+
+    if (saida == NULL) {
+        fprintf(stderr, "Não foi possível criar %s\n", arquivo);
+        return false;
+    }
+
+    memset(&cabecalho, 0, sizeof(cabecalho));
+    memcpy(cabecalho.magica, REDE_BINARIA_MAGICA, sizeof(REDE_BINARIA_MAGICA));
+    cabecalho.versao = REDE_BINARIA_VERSAO;
+    cabecalho.num_cruzamentos = rede.num_cruzamentos;
+    cabecalho.num_vias = rede.num_vias;
+    cabecalho.tamanho_nomes = rede.tamanho_nomes;
+
+    sucesso = escreverSecao(saida, &posicao, 0, &cabecalho, sizeof(cabecalho)) &&
+              escreverSecao(saida, &posicao, secoes.inicio_vias, rede.inicio_vias, (rede.num_cruzamentos + 1) * sizeof(uint32_t)) &&
+              escreverSecao(saida, &posicao, secoes.destino, rede.destino, rede.num_vias * sizeof(uint32_t)) &&
+              escreverSecao(saida, &posicao, secoes.comprimento, rede.comprimento, rede.num_vias * sizeof(float)) &&
+              escreverSecao(saida, &posicao, secoes.velocidade_maxima, rede.velocidade_maxima, rede.num_vias * sizeof(float)) &&
+              escreverSecao(saida, &posicao, secoes.inicio_nome, rede.inicio_nome, rede.num_cruzamentos * sizeof(uint32_t)) &&
+              escreverSecao(saida, &posicao, secoes.nomes, rede.nomes, rede.tamanho_nomes);
+    if (fclose(saida) != 0) {
+        sucesso = false;
+    }
+    if (!sucesso) {
+        fprintf(stderr, "Erro ao gravar %s\n", arquivo);
+    }
+    return sucesso;
+}
+
+// Retorna o nome do cruzamento
+const char *nomeCruzamento(uint32_t cruzamento) {
+    return rede.nomes + rede.inicio_nome[cruzamento];
+}
+
+// Sorteia uma das vias que saem do cruzamento
+uint32_t selecionarProximaVia(uint32_t cruzamento, aleatorio_t *gerador) {
+    uint32_t primeira = rede.inicio_vias[cruzamento];
+    uint32_t grau = rede.inicio_vias[cruzamento + 1] - primeira;
+
+    if (grau == 0) {
+        return VIA_INEXISTENTE;
+    }
+    return primeira + sortearIntervalo(gerador, grau);
+}
@@ -0,0 +1,49 @@
+#ifndef REDE_H
+#define REDE_H
+
+// Rede viária em formato CSR (compressed sparse row): as vias que saem do
+// cruzamento c ocupam as posições inicio_vias[c] até inicio_vias[c + 1] - 1
+// dos vetores de vias, então achar os vizinhos de um cruzamento é O(1)
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "aleatorio.h"
+
+#define VIA_INEXISTENTE UINT32_MAX // Retornado quando o cruzamento não tem vias de saída
+
+// Formato binário: cabeçalho seguido dos vetores da rede, cada um alinhado a
+// 8 bytes, na ordem inicio_vias, destino, comprimento, velocidade_maxima,
+// inicio_nome e nomes. O arquivo é mapeado com mmap e usado no lugar.
+#define REDE_BINARIA_MAGICA "REDEBIN"
+#define REDE_BINARIA_VERSAO 1
+
+typedef struct {
+    char magica[8];             // REDE_BINARIA_MAGICA
+    uint32_t versao;            // REDE_BINARIA_VERSAO
+    uint32_t num_cruzamentos;
+    uint32_t num_vias;
+    uint32_t tamanho_nomes;     // Bytes do vetor de nomes
+} cabecalho_rede_t;
+
+typedef struct {
+    uint32_t num_cruzamentos;
+    uint32_t num_vias;
+    const uint32_t *inicio_vias;        // Primeira via de saída de cada cruzamento (num_cruzamentos + 1 posições)
+    const uint32_t *destino;            // Cruzamento ao fim de cada via
+    const float *comprimento;           // Comprimento de cada via em metros
+    const float *velocidade_maxima;     // Velocidade máxima de cada via em km/h
+    const uint32_t *inicio_nome;        // Posição do nome de cada cruzamento em nomes
+    const char *nomes;                  // Nomes dos cruzamentos, terminados em '\0', em sequência
+    uint32_t tamanho_nomes;
+} rede_t;
+
+extern rede_t rede;
+
+bool carregarRede(const char *arquivo);
+bool criarRedePadrao(void);
+bool salvarRedeBinaria(const char *arquivo);
+const char *nomeCruzamento(uint32_t cruzamento);
+uint32_t selecionarProximaVia(uint32_t cruzamento, aleatorio_t *gerador);
+
+#endif
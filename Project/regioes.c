@@ -0,0 +1,677 @@
+#include <FreeRTOS.h>
+#include <task.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include "simulacao.h"
+#include "agentes.h"
+#include "regioes.h"
+#include "eventos.h"
+#include "roda.h"
+#include "alocacao.h"
+
+#define GIROS_ESPERA 100            // sched_yield antes de passar a dormir entre verificações
+#define ESPERA_REGIAO_NS 100000     // 100 us entre verificações depois dos giros
+#define CAPACIDADE_INICIAL 64       // veículos por região antes de crescer a tabela
+
+typedef enum {
+    AGENTE_APROXIMANDO,   // Sorteia velocidade e entra na via
+    AGENTE_AGUARDANDO,    // Aguarda espaço na via, que estava lotada
+    AGENTE_NA_VIA,        // Percorre a via e para na fila do movimento, até a região liberá-lo no verde
+    AGENTE_ATRAVESSANDO,  // Atravessa o cruzamento
+    AGENTE_TRANSFERINDO,  // Segue para outra região, com a fila cheia: tenta de novo no próximo passo
+    AGENTE_LIVRE          // Posição da tabela sem veículo
+} estado_agente_t;
+
+// Veículo em trânsito entre duas regiões
+typedef struct {
+    uint32_t id;
+    uint32_t via;               // Via pela qual se aproxima do cruzamento da região de destino
+    TickType_t chegada;         // Tick em que deixou o cruzamento de origem e entra na via
+    char movimento;
+    float velocidade;
+    aleatorio_t gerador;
+} transferencia_t;
+
+// Fila de um produtor (região de origem) e um consumidor (região de destino).
+// A origem publica 'escrita' ao fim de cada janela, alternando entre duas
+// posições pela paridade da janela. O destino lê, no início da janela
+// seguinte, a posição da janela anterior: mesmo que a origem já tenha
+// avançado mais uma janela, ele recebe exatamente os veículos daquela. Só
+// uma fila cheia, que retém o veículo na origem, deixa o resultado depender
+// do ritmo das threads.
+typedef struct {
+    unsigned int escrita;               // Próxima posição a escrever, só usada pela origem
+    atomic_uint publicada[2];           // 'escrita' ao fim das janelas pares e ímpares
+    unsigned int mascara;               // Capacidade - 1 (potência de 2)
+    _Alignas(64) atomic_uint cauda;     // Próxima posição a ler, só avançada pelo destino
+    _Alignas(64) transferencia_t itens[];
+} fila_transferencias_t;
+
+// Tabela de veículos da região, como estrutura de vetores (ver agentes.c). Ela
+// cresce conforme os veículos entram na região, e a posição de quem sai é
+// reaproveitada: um veículo não muda de posição, que é o que as filas guardam.
+typedef struct {
+    uint32_t quantidade;        // Posições em uso, com ou sem veículo
+    uint32_t capacidade;
+    uint32_t num_livres;
+    uint32_t *livres;           // Posições sem veículo, reaproveitadas antes de crescer a tabela
+    uint32_t *id;
+    uint32_t *via;
+    char *movimento;
+    float *velocidade;
+    uint16_t *tempo_percurso;
+    uint8_t *estado;            // estado_agente_t
+    aleatorio_t *gerador;
+    uint32_t *proximo;          // Próximo veículo no mesmo compartimento da roda
+    uint32_t *passo;            // Passo da próxima ação do veículo
+    roda_t roda;                // Próximas ações dos veículos, ligadas por 'proximo' e 'passo'
+} agentes_regiao_t;
+
+// Região: o trabalho de uma janela. Qualquer trabalhadora pode avançá-la,
+// mas só uma por janela, então o estado da região não tem travas.
+typedef struct {
+    uint32_t indice;
+    uint32_t primeiro;          // Primeiro cruzamento da região
+    uint32_t ultimo;            // Um após o último cruzamento da região
+    int fase;                   // Fase aberta nos cruzamentos da região (os ciclos começam juntos), -1 antes da primeira
+    TickType_t inicio_fase;
+    uint32_t saidas_fase;       // Saídas de cada fila permitidas desde o início da fase
+    agentes_regiao_t agentes;
+    fila_transferencias_t **entradas;   // Filas vindas de outras regiões, na ordem da origem
+    uint32_t num_entradas;
+    fila_transferencias_t **saidas;     // Filas para outras regiões
+    uint32_t num_saidas;
+    uint32_t travessias;
+    uint32_t finalizados;
+    uint32_t transferencias;    // Veículos entregues a outras regiões
+    uint64_t atualizacoes;      // Ações de veículos executadas (métricas)
+} regiao_t;
+
+// Thread trabalhadora. 'restantes' guarda as regiões [início, fim) que ela
+// ainda não tomou na janela, empacotadas em 64 bits: a dona toma do início,
+// na ordem das faixas, e as outras roubam do fim quando ficam sem trabalho.
+typedef struct {
+    _Alignas(64) _Atomic uint64_t restantes;
+    uint32_t indice;
+    uint32_t roubos;            // Regiões tomadas de outras trabalhadoras
+    pthread_t thread;
+} trabalhadora_t;
+
+static regiao_t *regioes = NULL;
+static int num_regioes = 0;
+static trabalhadora_t *trabalhadoras = NULL;
+static int num_trabalhadoras = 0;
+static int threads_ativas = 0;
+static uint32_t num_veiculos = 0;
+static uint32_t *regiao_cruzamento = NULL;       // Região dona de cada cruzamento
+static fila_transferencias_t **fila_via = NULL;  // Fila usada por quem segue por cada via (NULL dentro da região)
+static fila_aproximacao_t *aproximacoes = NULL; // NUM_FASES filas por cruzamento, usadas só pela região dona
+
+// Janela atual: a coordenadora escreve o início antes de publicar a janela
+static TickType_t inicio_janela;
+static atomic_uint janela;          // Número da janela publicada
+static atomic_int pendentes;        // Trabalhadoras que ainda não terminaram a janela
+static atomic_bool encerrando;
+
+// Espera ativa curta e, depois de GIROS_ESPERA tentativas, com pausas
+static void esperarVez(unsigned int *tentativas) {
+    const struct timespec espera = { 0, ESPERA_REGIAO_NS };
+
+    if (++*tentativas < GIROS_ESPERA) {
+        sched_yield();
+    } else {
+        nanosleep(&espera, NULL);
+    }
+}
+
+// Fase de todos os cruzamentos no instante 'agora', como índice em FASES. O
+// ciclo de vCruzamentoTask começa no tick 0 em todos eles, então a fase só depende do tempo.
+static int faseNoInstante(TickType_t agora) {
+    return (int)((agora / pdMS_TO_TICKS(DURACAO_FASE_MS)) % NUM_FASES);
+}
+
+// Região dona da via: a do cruzamento ao fim dela, que recebe os veículos que chegam
+static uint32_t regiaoDaVia(uint32_t via) {
+    return regiao_cruzamento[rede.destino[via]];
+}
+
+// Garante espaço para 'quantidade' veículos na tabela da região
+static bool reservarAgentes(agentes_regiao_t *tabela, uint32_t quantidade) {
+    uint32_t capacidade = tabela->capacidade ? tabela->capacidade : CAPACIDADE_INICIAL;
+    void *vetor;
+
+    if (quantidade <= tabela->capacidade) {
+        return true;
+    }
+    while (capacidade < quantidade) {
+        capacidade *= 2;
+    }
+
+    // Cada vetor é trocado assim que realocado: se um falhar, os anteriores continuam válidos
+#define REALOCAR(campo) \
+    if ((vetor = realloc(tabela->campo, capacidade * sizeof(*tabela->campo))) == NULL) { \
+        return false; \
+    } \
+    tabela->campo = vetor;
+
+    REALOCAR(id)
+    REALOCAR(via)
+    REALOCAR(movimento)
+    REALOCAR(velocidade)
+    REALOCAR(tempo_percurso)
+    REALOCAR(estado)
+    REALOCAR(gerador)
+    REALOCAR(proximo)
+    REALOCAR(passo)
+    REALOCAR(livres)
+#undef REALOCAR
+
+    tabela->roda.proximo = tabela->proximo;
+    tabela->roda.passo = tabela->passo;
+    tabela->capacidade = capacidade;
+    return true;
+}
+
+// Posição que o próximo veículo acrescentado vai ocupar (há espaço reservado)
+static uint32_t proximaPosicao(const agentes_regiao_t *tabela) {
+    return tabela->num_livres > 0 ? tabela->livres[tabela->num_livres - 1] : tabela->quantidade;
+}
+
+// Acrescenta um veículo que se aproxima de um cruzamento da região, em
+// proximaPosicao(), no estado 'estado' (há espaço reservado), e devolve a posição
+static uint32_t adicionarAgente(agentes_regiao_t *tabela, const transferencia_t *veiculo, uint8_t estado) {
+    uint32_t i = tabela->num_livres > 0 ? tabela->livres[--tabela->num_livres] : tabela->quantidade++;
+
+    tabela->id[i] = veiculo->id;
+    tabela->via[i] = veiculo->via;
+    tabela->movimento[i] = veiculo->movimento;
+    tabela->velocidade[i] = veiculo->velocidade;
+    tabela->tempo_percurso[i] = 0;
+    tabela->estado[i] = estado;
+    tabela->gerador[i] = veiculo->gerador;
+    return i;
+}
+
+// Remove o veículo 'i', deixando a posição para o próximo que entrar
+static void removerAgente(agentes_regiao_t *tabela, uint32_t i) {
+    tabela->estado[i] = AGENTE_LIVRE;
+    tabela->livres[tabela->num_livres++] = i;
+}
+
+// Entrega o veículo 'i', que deixou o cruzamento em 'agora', à região dona
+// da sua via e o remove da tabela. Com a fila cheia o veículo fica, no
+// estado AGENTE_TRANSFERINDO, e tenta de novo no próximo passo.
+static void transferirAgente(regiao_t *regiao, uint32_t i, TickType_t agora) {
+    agentes_regiao_t *tabela = &regiao->agentes;
+    fila_transferencias_t *fila = fila_via[tabela->via[i]];
+    transferencia_t *veiculo;
+
+    if (fila->escrita - atomic_load_explicit(&fila->cauda, memory_order_acquire) > fila->mascara) {
+        tabela->estado[i] = AGENTE_TRANSFERINDO;
+        agendarRoda(&tabela->roda, i, passoDoPrazo(agora) + 1);
+        return;
+    }
+
+    veiculo = &fila->itens[fila->escrita++ & fila->mascara];
+    veiculo->id = tabela->id[i];
+    veiculo->via = tabela->via[i];
+    veiculo->chegada = agora;
+    veiculo->movimento = tabela->movimento[i];
+    veiculo->velocidade = tabela->velocidade[i];
+    veiculo->gerador = tabela->gerador[i];
+    regiao->transferencias++;
+    removerAgente(tabela, i);
+}
+
+// Publica os veículos entregues pela região na janela que termina
+static void publicarTransferencias(regiao_t *regiao, unsigned int janela_atual) {
+    for (uint32_t s = 0; s < regiao->num_saidas; s++) {
+        fila_transferencias_t *fila = regiao->saidas[s];
+
+        atomic_store_explicit(&fila->publicada[janela_atual % 2], fila->escrita, memory_order_release);
+    }
+}
+
+// Recebe os veículos entregues na janela anterior à 'janela_atual', na ordem
+// das regiões de origem, para a ordem da tabela (e a simulação) não depender
+// das threads. Cada um entra na sua via no tick em que deixou a origem: toda
+// via de outra região só recebe veículos por esta fila, então a ordem de
+// entrada na via se mantém. Com a via lotada o veículo espera na fila, e os
+// de trás com ele, até a próxima janela.
+static void receberTransferencias(regiao_t *regiao, unsigned int janela_atual) {
+    agentes_regiao_t *tabela = &regiao->agentes;
+
+    for (uint32_t e = 0; e < regiao->num_entradas; e++) {
+        fila_transferencias_t *fila = regiao->entradas[e];
+        unsigned int cauda, cabeca;
+
+        cauda = atomic_load_explicit(&fila->cauda, memory_order_relaxed);
+        cabeca = atomic_load_explicit(&fila->publicada[(janela_atual - 1) % 2], memory_order_acquire);
+
+        // Sem memória para crescer a tabela, os veículos esperam na fila (e a origem os retém)
+        if (!reservarAgentes(tabela, tabela->quantidade + (cabeca - cauda))) {
+            continue;
+        }
+        for (; cauda != cabeca; cauda++) {
+            const transferencia_t *veiculo = &fila->itens[cauda & fila->mascara];
+            uint32_t i = proximaPosicao(tabela);
+            uint16_t tempo;
+
+            if (!entrarVia(veiculo->via, i, veiculo->movimento, veiculo->velocidade, veiculo->chegada, &tempo)) {
+                break;
+            }
+            adicionarAgente(tabela, veiculo, AGENTE_NA_VIA);
+            tabela->tempo_percurso[i] = tempo;
+            registrarEvento(veiculo->chegada, EVENTO_APROXIMACAO, veiculo->id, rede.destino[veiculo->via],
+                            veiculo->movimento, veiculo->velocidade, tempo);
+        }
+        atomic_store_explicit(&fila->cauda, cauda, memory_order_release);
+    }
+}
+
+// Executa a próxima ação do veículo 'i', espelhando avancarAgente (agentes.c)
+static void avancarAgenteRegiao(regiao_t *regiao, uint32_t i, TickType_t agora) {
+    agentes_regiao_t *tabela = &regiao->agentes;
+    uint32_t destino = rede.destino[tabela->via[i]];
+    uint32_t proxima_via;
+
+    switch (tabela->estado[i]) {
+        case AGENTE_ATRAVESSANDO:
+            regiao->travessias++;
+
+            // Seleciona o próximo cruzamento ou finaliza a jornada
+            proxima_via = VIA_INEXISTENTE;
+            if (sortearIntervalo(&tabela->gerador[i], 2) == 0 && tabela->movimento[i] != 'F') {
+                proxima_via = selecionarProximaVia(destino, &tabela->gerador[i]);
+            }
+            if (proxima_via == VIA_INEXISTENTE) {
+                regiao->finalizados++;
+                registrarEvento(agora, EVENTO_FIM_JORNADA, tabela->id[i], destino, tabela->movimento[i], 0, 0);
+                removerAgente(tabela, i);
+                break;
+            }
+
+            tabela->via[i] = proxima_via;
+            destino = rede.destino[proxima_via];
+            registrarEvento(agora, EVENTO_PROXIMO_CRUZAMENTO, tabela->id[i], destino, tabela->movimento[i], 0, 0);
+            if (regiaoDaVia(proxima_via) != regiao->indice) {
+                // A região dona da via põe o veículo nela
+                tabela->velocidade[i] = sortearVelocidade(proxima_via, &tabela->gerador[i]);
+                transferirAgente(regiao, i, agora);
+                break;
+            }
+            // fallthrough
+        case AGENTE_APROXIMANDO:
+            tabela->velocidade[i] = sortearVelocidade(tabela->via[i], &tabela->gerador[i]);
+            // fallthrough
+        case AGENTE_AGUARDANDO:
+            if (!entrarVia(tabela->via[i], i, tabela->movimento[i], tabela->velocidade[i], agora, &tabela->tempo_percurso[i])) {
+                // Via lotada, tenta novamente em 1 segundo
+                tabela->estado[i] = AGENTE_AGUARDANDO;
+                agendarRoda(&tabela->roda, i, passoDoPrazo(agora + pdMS_TO_TICKS(1000)));
+                break;
+            }
+            tabela->estado[i] = AGENTE_NA_VIA;
+            registrarEvento(agora, EVENTO_APROXIMACAO, tabela->id[i], destino, tabela->movimento[i],
+                            tabela->velocidade[i], tabela->tempo_percurso[i]);
+            break;
+        case AGENTE_TRANSFERINDO:
+            transferirAgente(regiao, i, agora);
+            break;
+        default:
+            break;
+    }
+}
+
+// Passa para as filas dos cruzamentos os veículos que chegaram ao fim das
+// vias, e libera das filas da fase 'fase' os que saem no passo, como
+// vCruzamentoTask: um por intervalo de saturação desde o início da fase
+static void liberarFilas(regiao_t *regiao, int fase, TickType_t agora) {
+    agentes_regiao_t *tabela = &regiao->agentes;
+    uint32_t saidas = saidasAte(regiao->inicio_fase, agora);
+    uint32_t liberar = saidas - regiao->saidas_fase;
+
+    regiao->saidas_fase = saidas;
+    for (uint32_t c = regiao->primeiro; c < regiao->ultimo; c++) {
+        fila_aproximacao_t *fila = &aproximacoes[c * NUM_FASES + fase];
+        uint32_t i, via;
+        char movimento;
+
+        for (uint32_t e = inicio_entradas[c]; e < inicio_entradas[c + 1]; e++) {
+            via = vias_entrada[e];
+            while (chegadaNaVia(via, agora, &i, &movimento) &&
+                   entrarFila(&aproximacoes[c * NUM_FASES + indiceAproximacao(movimento)], i, via)) {
+                retirarChegada(via);
+            }
+        }
+
+        for (uint32_t n = 0; n < liberar && sairFila(fila, &i, &via); n++) {
+            sairVia(via);
+            tabela->estado[i] = AGENTE_ATRAVESSANDO;
+            agendarRoda(&tabela->roda, i, passoDoPrazo(agora + sortearTravessia(&tabela->gerador[i])));
+            registrarEvento(agora, EVENTO_TRAVESSIA, tabela->id[i], c, tabela->movimento[i],
+                            tabela->velocidade[i], tabela->tempo_percurso[i]);
+        }
+    }
+}
+
+// Avança a região até o instante 'agora': executa os veículos cujo prazo
+// venceu, tirados da roda, troca a fase, se mudou, e libera os veículos das filas no verde.
+// Os veículos agem antes das filas, como as trabalhadoras do modo de agentes,
+// que têm prioridade maior que as tarefas dos cruzamentos.
+static void avancarPasso(regiao_t *regiao, TickType_t agora) {
+    agentes_regiao_t *tabela = &regiao->agentes;
+    int fase = faseNoInstante(agora);
+    uint32_t passo = agora / pdMS_TO_TICKS(PASSO_AGENTES_MS);
+
+    while ((int32_t)(passo - tabela->roda.atual) >= 0) {
+        uint32_t i = expirarRoda(&tabela->roda);
+
+        while (i != RODA_VAZIA) {
+            uint32_t proximo = tabela->proximo[i]; // avancarAgenteRegiao pode agendar o veículo de novo
+
+            regiao->atualizacoes++;
+            avancarAgenteRegiao(regiao, i, agora);
+            i = proximo;
+        }
+    }
+
+    if (fase != regiao->fase) {
+        for (uint32_t c = regiao->primeiro; c < regiao->ultimo; c++) {
+            registrarEvento(agora, EVENTO_FASE, 0, c, FASES[fase], 0, 0);
+        }
+        regiao->fase = fase;
+        regiao->inicio_fase = agora;
+        regiao->saidas_fase = 0;
+    }
+    liberarFilas(regiao, fase, agora);
+}
+
+// Avança uma região pelos passos da janela 'janela_atual'
+static void avancarJanela(regiao_t *regiao, unsigned int janela_atual) {
+    receberTransferencias(regiao, janela_atual);
+    for (TickType_t passo = 0; passo < pdMS_TO_TICKS(JANELA_REGIOES_MS); passo += pdMS_TO_TICKS(PASSO_AGENTES_MS)) {
+        avancarPasso(regiao, inicio_janela + passo);
+    }
+    publicarTransferencias(regiao, janela_atual);
+}
+
+// Toma uma região ainda não avançada da trabalhadora 't': do início se
+// 'roubar' é false (a dona), do fim se é true (outra trabalhadora)
+static bool tomarRegiao(trabalhadora_t *t, bool roubar, uint32_t *regiao) {
+    uint64_t atual = atomic_load_explicit(&t->restantes, memory_order_acquire);
+
+    while (1) {
+        uint32_t inicio = (uint32_t)(atual >> 32);
+        uint32_t fim = (uint32_t)atual;
+        uint64_t novo;
+
+        if (inicio >= fim) {
+            return false;
+        }
+        novo = roubar ? ((uint64_t)inicio << 32) | (fim - 1) : ((uint64_t)(inicio + 1) << 32) | fim;
+        if (atomic_compare_exchange_weak_explicit(&t->restantes, &atual, novo,
+                                                  memory_order_acq_rel, memory_order_acquire)) {
+            *regiao = roubar ? fim - 1 : inicio;
+            return true;
+        }
+    }
+}
+
+// Thread trabalhadora: a cada janela publicada avança as regiões da sua
+// faixa e depois rouba as que sobraram nas outras. Nenhuma região gera
+// trabalho novo na janela, então sem nada para roubar a janela acabou.
+static void *executarTrabalhadora(void *parametro) {
+    trabalhadora_t *trabalhadora = parametro;
+    unsigned int ultima_janela = 0;
+
+    while (1) {
+        unsigned int tentativas = 0;
+        uint32_t regiao;
+
+        while (atomic_load_explicit(&janela, memory_order_acquire) == ultima_janela) {
+            if (atomic_load(&encerrando)) {
+                return NULL;
+            }
+            esperarVez(&tentativas);
+        }
+        ultima_janela++;
+
+        while (tomarRegiao(trabalhadora, false, &regiao)) {
+            avancarJanela(&regioes[regiao], ultima_janela);
+        }
+        for (int v = 1; v < num_trabalhadoras; v++) {
+            trabalhadora_t *vitima = &trabalhadoras[(trabalhadora->indice + v) % num_trabalhadoras];
+
+            while (tomarRegiao(vitima, true, &regiao)) {
+                trabalhadora->roubos++;
+                avancarJanela(&regioes[regiao], ultima_janela);
+            }
+        }
+        atomic_fetch_sub_explicit(&pendentes, 1, memory_order_release);
+    }
+}
+
+// Tarefa coordenadora: a cada JANELA_REGIOES_MS distribui as regiões em
+// faixas contíguas pelas trabalhadoras, abre a janela e espera as
+// trabalhadoras a concluírem antes de deixar o tempo avançar
+static void vCoordenadorRegioesTask(void *pvParameters) {
+    TickType_t ultima_janela = xTaskGetTickCount();
+
+    (void)pvParameters;
+    while (1) {
+        unsigned int tentativas = 0;
+
+        inicio_janela = ultima_janela;
+        for (int t = 0; t < num_trabalhadoras; t++) {
+            uint64_t inicio = (uint64_t)num_regioes * t / num_trabalhadoras;
+            uint64_t fim = (uint64_t)num_regioes * (t + 1) / num_trabalhadoras;
+
+            atomic_store_explicit(&trabalhadoras[t].restantes, (inicio << 32) | fim, memory_order_relaxed);
+        }
+        atomic_store_explicit(&pendentes, num_trabalhadoras, memory_order_relaxed);
+        atomic_fetch_add_explicit(&janela, 1, memory_order_release);
+        while (atomic_load_explicit(&pendentes, memory_order_acquire) > 0) {
+            esperarVez(&tentativas);
+        }
+        vTaskDelayUntil(&ultima_janela, pdMS_TO_TICKS(JANELA_REGIOES_MS));
+    }
+}
+
+// Acrescenta 'fila' ao vetor 'lista' de 'quantidade' filas
+static bool acrescentarFila(fila_transferencias_t ***lista, uint32_t *quantidade, fila_transferencias_t *fila) {
+    fila_transferencias_t **novo = realloc(*lista, (*quantidade + 1) * sizeof(*novo));
+
+    if (novo == NULL) {
+        return false;
+    }
+    novo[(*quantidade)++] = fila;
+    *lista = novo;
+    return true;
+}
+
+// Cria uma fila para cada par de regiões ligadas por alguma via, com
+// 'capacidade' veículos, e aponta cada via entre regiões para a sua fila.
+// Uma via só sai de cruzamentos da região de origem, então as filas de uma
+// origem são criadas juntas e as entradas de cada destino ficam na ordem da origem.
+static bool criarFilas(unsigned int capacidade) {
+    fila_via = calloc(rede.num_vias, sizeof(*fila_via));
+    if (fila_via == NULL) {
+        return false;
+    }
+    for (int origem = 0; origem < num_regioes; origem++) {
+        regiao_t *regiao = &regioes[origem];
+
+        for (uint32_t v = rede.inicio_vias[regiao->primeiro]; v < rede.inicio_vias[regiao->ultimo]; v++) {
+            regiao_t *destino = &regioes[regiaoDaVia(v)];
+            fila_transferencias_t *fila = NULL;
+
+            if (destino == regiao) {
+                continue;
+            }
+            // Reaproveita a fila que esta origem já criou para o mesmo destino (a última entrada dele)
+            if (destino->num_entradas > 0) {
+                fila_transferencias_t *ultima = destino->entradas[destino->num_entradas - 1];
+
+                for (uint32_t s = 0; s < regiao->num_saidas && fila == NULL; s++) {
+                    if (regiao->saidas[s] == ultima) {
+                        fila = ultima;
+                    }
+                }
+            }
+            if (fila == NULL) {
+                size_t tamanho = sizeof(*fila) + capacidade * sizeof(transferencia_t);
+
+                fila = aligned_alloc(64, (tamanho + 63) & ~(size_t)63);
+                if (fila == NULL || !acrescentarFila(&regiao->saidas, &regiao->num_saidas, fila) ||
+                    !acrescentarFila(&destino->entradas, &destino->num_entradas, fila)) {
+                    return false;
+                }
+                fila->escrita = 0;
+                fila->mascara = capacidade - 1;
+                atomic_init(&fila->publicada[0], 0);
+                atomic_init(&fila->publicada[1], 0);
+                atomic_init(&fila->cauda, 0);
+            }
+            fila_via[v] = fila;
+        }
+    }
+    return true;
+}
+
+// Divide a rede em 'regioes' faixas de cruzamentos contíguos, distribui os
+// 'quantidade' veículos (sorteados como em criarAgentes) pela região do
+// cruzamento de destino e cria as 'trabalhadoras' threads e a coordenadora.
+// As tabelas usam malloc: as trabalhadoras as realocam fora do FreeRTOS.
+bool criarRegioes(uint32_t quantidade, int regioes_pedidas, int trabalhadoras_pedidas, uint64_t semente) {
+    unsigned int capacidade = FILA_TRANSFERENCIAS_MINIMA;
+    sigset_t todos, anteriores;
+
+    if (quantidade == 0 || regioes_pedidas <= 0 || trabalhadoras_pedidas <= 0) {
+        return false;
+    }
+    num_regioes = regioes_pedidas;
+    if ((uint32_t)num_regioes > rede.num_cruzamentos) {
+        num_regioes = (int)rede.num_cruzamentos;
+    }
+    num_trabalhadoras = trabalhadoras_pedidas < num_regioes ? trabalhadoras_pedidas : num_regioes;
+
+    regioes = calloc(num_regioes, sizeof(*regioes));
+    trabalhadoras = aligned_alloc(64, num_trabalhadoras * sizeof(*trabalhadoras));
+    regiao_cruzamento = malloc(rede.num_cruzamentos * sizeof(*regiao_cruzamento));
+    aproximacoes = calloc((size_t)rede.num_cruzamentos * NUM_FASES, sizeof(*aproximacoes));
+    if (regioes == NULL || trabalhadoras == NULL || regiao_cruzamento == NULL || aproximacoes == NULL) {
+        return false;
+    }
+    for (int r = 0; r < num_regioes; r++) {
+        regioes[r].indice = (uint32_t)r;
+        regioes[r].primeiro = (uint32_t)((uint64_t)rede.num_cruzamentos * r / num_regioes);
+        regioes[r].ultimo = (uint32_t)((uint64_t)rede.num_cruzamentos * (r + 1) / num_regioes);
+        regioes[r].fase = -1;
+        iniciarRoda(&regioes[r].agentes.roda, NULL, NULL); // Os vetores da roda vêm com a tabela
+        for (uint32_t c = regioes[r].primeiro; c < regioes[r].ultimo; c++) {
+            regiao_cruzamento[c] = (uint32_t)r;
+        }
+    }
+
+    // Filas com cerca de um quarto dos veículos de uma região: numa janela só
+    // uma pequena parte deles muda de região, e o excesso espera na origem
+    while (capacidade < FILA_TRANSFERENCIAS_MAXIMA && capacidade < quantidade / num_regioes / 4) {
+        capacidade *= 2;
+    }
+    if (!criarFilas(capacidade)) {
+        return false;
+    }
+
+    num_veiculos = quantidade;
+    for (uint32_t i = 0; i < quantidade; i++) {
+        transferencia_t veiculo;
+        regiao_t *regiao;
+
+        veiculo.id = i + 1; // ID do veículo começa em 1
+        iniciarAleatorio(&veiculo.gerador, semente, veiculo.id);
+        veiculo.via = sortearIntervalo(&veiculo.gerador, rede.num_vias);
+        veiculo.movimento = sortearMovimento(&veiculo.gerador);
+        veiculo.velocidade = 0;
+        veiculo.chegada = 0;
+
+        regiao = &regioes[regiaoDaVia(veiculo.via)];
+        if (!reservarAgentes(&regiao->agentes, regiao->agentes.quantidade + 1)) {
+            return false;
+        }
+        agendarRoda(&regiao->agentes.roda, adicionarAgente(&regiao->agentes, &veiculo, AGENTE_APROXIMANDO),
+                    passoDoPrazo(veiculo.chegada));
+    }
+
+    atomic_init(&janela, 0);
+    atomic_init(&pendentes, 0);
+    atomic_init(&encerrando, false);
+
+    // As trabalhadoras não podem receber os sinais que o porte usa para o tick e as trocas de contexto
+    sigfillset(&todos);
+    pthread_sigmask(SIG_SETMASK, &todos, &anteriores);
+    for (int t = 0; t < num_trabalhadoras; t++) {
+        trabalhadoras[t].indice = (uint32_t)t;
+        trabalhadoras[t].roubos = 0;
+        atomic_init(&trabalhadoras[t].restantes, 0);
+        if (pthread_create(&trabalhadoras[t].thread, NULL, executarTrabalhadora, &trabalhadoras[t]) != 0) {
+            pthread_sigmask(SIG_SETMASK, &anteriores, NULL);
+            encerrarRegioes();
+            return false;
+        }
+        threads_ativas++;
+    }
+    pthread_sigmask(SIG_SETMASK, &anteriores, NULL);
+
+    return criarTarefa(vCoordenadorRegioesTask,
+                       "Regioes Task",
+                       0,
+                       NULL,
+                       2) != NULL;
+}
+
+// Para as trabalhadoras; a janela em andamento é concluída antes
+void encerrarRegioes(void) {
+    atomic_store(&encerrando, true);
+    for (int t = 0; t < threads_ativas; t++) {
+        pthread_join(trabalhadoras[t].thread, NULL);
+    }
+    threads_ativas = 0;
+}
+
+// Imprime o total de travessias, de jornadas finalizadas, de entregas entre regiões e de roubos
+void imprimirResumoRegioes(void) {
+    uint32_t travessias = 0;
+    uint32_t finalizados = 0;
+    uint32_t transferencias = 0;
+    uint32_t roubos = 0;
+
+    for (int r = 0; r < num_regioes; r++) {
+        travessias += regioes[r].travessias;
+        finalizados += regioes[r].finalizados;
+        transferencias += regioes[r].transferencias;
+    }
+    for (int t = 0; t < num_trabalhadoras; t++) {
+        roubos += trabalhadoras[t].roubos;
+    }
+    printf("Regiões: %d regiões em %d trabalhadoras, %u veículos, %u travessias, %u jornadas finalizadas, "
+           "%u transferências, %u roubos\n",
+           num_regioes, num_trabalhadoras, (unsigned)num_veiculos, (unsigned)travessias, (unsigned)finalizados,
+           (unsigned)transferencias, (unsigned)roubos);
+}
+
+// Soma as ações de veículos executadas pelas regiões
+uint64_t totalAtualizacoesRegioes(void) {
+    uint64_t total = 0;
+
+    for (int r = 0; r < num_regioes; r++) {
+        total += regioes[r].atualizacoes;
+    }
+    return total;
+}
@@ -0,0 +1,32 @@
+#ifndef REGIOES_H
+#define REGIOES_H
+
+// Modo paralelo: a rede é dividida em regiões de cruzamentos contíguos e
+// threads do sistema, fora do FreeRTOS, avançam as regiões ao mesmo tempo.
+// Cada região é um trabalho independente dentro de uma janela; as
+// trabalhadoras começam pelas regiões da sua faixa e roubam as que sobraram
+// nas outras, para uma região congestionada não deixar núcleos parados. Um
+// veículo que segue para um cruzamento de outra região é entregue a ela por
+// uma fila sem travas (um produtor e um consumidor por par de regiões
+// ligadas por alguma via).
+//
+// A sincronização é conservadora: uma tarefa coordenadora abre janelas de
+// JANELA_REGIOES_MS e espera todas as regiões terminarem cada uma. A região
+// dona de uma via é a do cruzamento ao fim dela; um veículo entregue entra na
+// via no tick em que saiu da origem e leva no mínimo TEMPO_MINIMO_VIA_MS para
+// chegar ao fim, então nada do que uma região recebe age na janela em que
+// foi entregue e as filas só precisam ser lidas no início de cada janela.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define JANELA_REGIOES_MS 2000                 // Não pode passar de TEMPO_MINIMO_VIA_MS (vias.h)
+#define FILA_TRANSFERENCIAS_MINIMA 64          // veículos por fila entre duas regiões (potência de 2)
+#define FILA_TRANSFERENCIAS_MAXIMA 16384
+
+bool criarRegioes(uint32_t quantidade, int regioes, int trabalhadoras, uint64_t semente);
+void encerrarRegioes(void);
+void imprimirResumoRegioes(void);
+uint64_t totalAtualizacoesRegioes(void);
+
+#endif
@@ -0,0 +1,71 @@
+#include "roda.h"
+
+// Começa a roda vazia, no passo 0, com as listas nos vetores 'proximo' e 'passo'
+void iniciarRoda(roda_t *roda, uint32_t *proximo, uint32_t *passo) {
+    roda->atual = 0;
+    roda->proximo = proximo;
+    roda->passo = passo;
+    for (int n = 0; n < RODA_NIVEIS; n++) {
+        for (uint32_t c = 0; c < RODA_COMPARTIMENTOS; c++) {
+            roda->compartimentos[n][c] = RODA_VAZIA;
+        }
+    }
+}
+
+// Agenda 'item' para o passo 'passo'; um passo já vencido vira o próximo a
+// vencer. O nível é o mais baixo em que o passo e o atual caem no mesmo
+// compartimento do nível de cima, então o compartimento escolhido ainda não
+// foi redistribuído.
+void agendarRoda(roda_t *roda, uint32_t item, uint32_t passo) {
+    uint32_t *lista;
+    int nivel = 0;
+
+    if ((int32_t)(passo - roda->atual) < 0) {
+        passo = roda->atual;
+    }
+    while (nivel < RODA_NIVEIS - 1 &&
+           (passo >> (RODA_BITS * (nivel + 1))) != (roda->atual >> (RODA_BITS * (nivel + 1)))) {
+        nivel++;
+    }
+
+    lista = &roda->compartimentos[nivel][(passo >> (RODA_BITS * nivel)) & (RODA_COMPARTIMENTOS - 1)];
+    roda->passo[item] = passo;
+    roda->proximo[item] = *lista;
+    *lista = item;
+}
+
+// Redistribui nos níveis de baixo o compartimento 'compartimento' do nível 'nivel'
+static void redistribuir(roda_t *roda, int nivel, uint32_t compartimento) {
+    uint32_t item = roda->compartimentos[nivel][compartimento];
+
+    roda->compartimentos[nivel][compartimento] = RODA_VAZIA;
+    while (item != RODA_VAZIA) {
+        uint32_t proximo = roda->proximo[item];
+
+        agendarRoda(roda, item, roda->passo[item]);
+        item = proximo;
+    }
+}
+
+// Retira da roda e devolve a lista dos itens que vencem no passo atual
+// (RODA_VAZIA se não há nenhum) e avança para o passo seguinte. A lista é
+// percorrida por 'proximo', que deve ser lido antes de agendar o item de novo.
+uint32_t expirarRoda(roda_t *roda) {
+    uint32_t atual = roda->atual;
+    uint32_t compartimento = atual & (RODA_COMPARTIMENTOS - 1);
+    uint32_t lista;
+    int nivel = 1;
+
+    // No início de um compartimento de um nível, redistribui os de cima, do mais alto para o mais baixo
+    while (nivel < RODA_NIVEIS && (atual & ((1u << (RODA_BITS * nivel)) - 1)) == 0) {
+        nivel++;
+    }
+    for (nivel--; nivel >= 1; nivel--) {
+        redistribuir(roda, nivel, (atual >> (RODA_BITS * nivel)) & (RODA_COMPARTIMENTOS - 1));
+    }
+
+    lista = roda->compartimentos[0][compartimento];
+    roda->compartimentos[0][compartimento] = RODA_VAZIA;
+    roda->atual = atual + 1;
+    return lista;
+}
@@ -0,0 +1,32 @@
+#ifndef RODA_H
+#define RODA_H
+
+// Roda de tempo hierárquica: agenda itens (índices de veículos) para um passo
+// futuro e devolve, a cada passo, a lista dos que vencem nele, em O(1) por
+// item. O nível 0 tem um compartimento por passo; cada nível acima cobre
+// RODA_COMPARTIMENTOS compartimentos do de baixo e é redistribuído nele
+// quando o passo atual chega ao início do seu compartimento.
+//
+// As listas são ligadas pelos próprios itens: o dono fornece os vetores
+// 'proximo' e 'passo', com uma posição por item, e um item só pode estar
+// agendado uma vez. A roda não tem travas.
+
+#include <stdint.h>
+
+#define RODA_BITS 6                                 // Compartimentos por nível = 2^RODA_BITS
+#define RODA_COMPARTIMENTOS (1u << RODA_BITS)
+#define RODA_NIVEIS 6                               // RODA_BITS * RODA_NIVEIS >= 32: cobre qualquer passo
+#define RODA_VAZIA UINT32_MAX                       // Fim de lista
+
+typedef struct {
+    uint32_t atual;         // Próximo passo a vencer
+    uint32_t *proximo;      // Item seguinte na lista de cada item
+    uint32_t *passo;        // Passo em que cada item vence
+    uint32_t compartimentos[RODA_NIVEIS][RODA_COMPARTIMENTOS];
+} roda_t;
+
+void iniciarRoda(roda_t *roda, uint32_t *proximo, uint32_t *passo);
+void agendarRoda(roda_t *roda, uint32_t item, uint32_t passo);
+uint32_t expirarRoda(roda_t *roda);
+
+#endif
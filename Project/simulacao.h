@@ -0,0 +1,82 @@
+#ifndef SIMULACAO_H
+#define SIMULACAO_H
+
+// Definições compartilhadas entre o modo de tarefas (main.c) e o modo de agentes (agentes.c)
+
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <stdbool.h>
+
+#include "rede.h"
+#include "aleatorio.h"
+#include "vias.h"
+
+#define FASES "NEX"           // 'N': NS-Straight e EW-Left, 'E': EW-Straight e NS-Left, 'X': conversão à direita
+#define NUM_FASES 3
+#define DURACAO_FASE_MS 10000 // Cada fase fica aberta 10 segundos
+#define PASSO_CRUZAMENTO_MS 1000 // Resolução das chegadas e das saídas das filas dos cruzamentos
+
+#define FLUXO_SATURACAO_PADRAO 1800  // veículos por hora de verde que deixam uma fila
+#define FILA_APROXIMACAO_CAPACIDADE 64 // veículos parados por aproximação (potência de 2): ~500 m de faixa a 7,5 m por veículo
+
+// Fila de veículos parados em uma aproximação do cruzamento, como anel.
+// Guarda o índice do veículo (da tarefa, do agente ou da posição na tabela
+// da região) e a via em que ele está parado, e os anéis de um cruzamento
+// ficam juntos na memória.
+typedef struct {
+    uint32_t inicio;                                // Posição do primeiro veículo
+    uint32_t quantidade;
+    uint32_t veiculos[FILA_APROXIMACAO_CAPACIDADE];
+    uint32_t vias[FILA_APROXIMACAO_CAPACIDADE];
+} fila_aproximacao_t;
+
+typedef struct {
+    char id;                     // Identificador único do semáforo
+    bool estado;                 // Estado do semáforo (0 = vermelho, 1 = verde)
+    int time_green_red;         // Tempo para vermelho e para o verde para mudar de estado (em segundos)
+} semaforo_t;
+
+typedef struct {
+    const char *id;             // Identificador único do cruzamento (nome na rede)
+    semaforo_t semaforos[4];      // Semáforos de cada cruzamento
+    fila_aproximacao_t aproximacoes[NUM_FASES]; // Veículos parados por movimento, na ordem de FASES ('F', 'L', 'R')
+} cruzamento_t;
+
+extern cruzamento_t *cruzamentos; // vetor de cruzamentos, um por cruzamento da rede
+extern uint32_t fluxo_saturacao;  // veículos por hora de verde que deixam cada fila
+
+float calcularTempoPercurso(float velocidade, float comprimento);
+float sortearVelocidade(uint32_t via, aleatorio_t *gerador);
+char sortearMovimento(aleatorio_t *gerador);
+uint32_t indiceAproximacao(char movimento);
+TickType_t intervaloSaturacao(void);
+uint32_t saidasAte(TickType_t inicio_fase, TickType_t agora);
+TickType_t sortearTravessia(aleatorio_t *gerador);
+bool entrarNaVia(uint32_t via, uint32_t veiculo, char movimento, float velocidade, TickType_t agora, uint16_t *tempo);
+
+// Põe 'veiculo', parado em 'via', no fim da fila; devolve false com a fila cheia
+static inline bool entrarFila(fila_aproximacao_t *fila, uint32_t veiculo, uint32_t via) {
+    uint32_t posicao = (fila->inicio + fila->quantidade) & (FILA_APROXIMACAO_CAPACIDADE - 1);
+
+    if (fila->quantidade == FILA_APROXIMACAO_CAPACIDADE) {
+        return false;
+    }
+    fila->veiculos[posicao] = veiculo;
+    fila->vias[posicao] = via;
+    fila->quantidade++;
+    return true;
+}
+
+// Tira o primeiro veículo da fila, com a via de onde sai; devolve false com a fila vazia
+static inline bool sairFila(fila_aproximacao_t *fila, uint32_t *veiculo, uint32_t *via) {
+    if (fila->quantidade == 0) {
+        return false;
+    }
+    *veiculo = fila->veiculos[fila->inicio];
+    *via = fila->vias[fila->inicio];
+    fila->inicio = (fila->inicio + 1) & (FILA_APROXIMACAO_CAPACIDADE - 1);
+    fila->quantidade--;
+    return true;
+}
+
+#endif
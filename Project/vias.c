@@ -0,0 +1,123 @@
+#include <stdlib.h>
+
+#include "simulacao.h"
+#include "vias.h"
+
+via_t *vias = NULL;
+uint32_t *inicio_entradas = NULL;
+uint32_t *vias_entrada = NULL;
+
+// Anéis de todas as vias, um após o outro (cada via usa 'capacidade' posições a partir de 'base')
+static uint32_t *veiculos_vias = NULL;
+static TickType_t *chegadas_vias = NULL;
+static char *movimentos_vias = NULL;
+
+// Cria o estado das vias da rede carregada e o índice das vias de entrada de
+// cada cruzamento. É chamada antes do agendador, por isso usa malloc.
+bool criarVias(void) {
+    uint32_t total = 0;
+    uint32_t *postas;           // Entradas já postas de cada cruzamento
+
+    vias = malloc(rede.num_vias * sizeof(*vias));
+    inicio_entradas = calloc(rede.num_cruzamentos + 1, sizeof(*inicio_entradas));
+    vias_entrada = malloc(rede.num_vias * sizeof(*vias_entrada));
+    if (vias == NULL || inicio_entradas == NULL || vias_entrada == NULL) {
+        return false;
+    }
+
+    for (uint32_t v = 0; v < rede.num_vias; v++) {
+        uint32_t capacidade = (uint32_t)(rede.comprimento[v] / ESPACO_VEICULO_M);
+
+        vias[v].base = total;
+        vias[v].capacidade = capacidade > 0 ? capacidade : 1;
+        vias[v].ocupacao = 0;
+        vias[v].inicio = 0;
+        vias[v].em_transito = 0;
+        vias[v].ultima_chegada = 0;
+        total += vias[v].capacidade;
+        inicio_entradas[rede.destino[v] + 1]++;
+    }
+
+    // Vias de entrada em formato CSR, como as de saída da rede
+    for (uint32_t c = 0; c < rede.num_cruzamentos; c++) {
+        inicio_entradas[c + 1] += inicio_entradas[c];
+    }
+    postas = calloc(rede.num_cruzamentos, sizeof(*postas));
+    if (postas == NULL) {
+        return false;
+    }
+    for (uint32_t v = 0; v < rede.num_vias; v++) {
+        uint32_t destino = rede.destino[v];
+
+        vias_entrada[inicio_entradas[destino] + postas[destino]++] = v;
+    }
+    free(postas);
+
+    veiculos_vias = malloc(total * sizeof(*veiculos_vias));
+    chegadas_vias = malloc(total * sizeof(*chegadas_vias));
+    movimentos_vias = malloc(total * sizeof(*movimentos_vias));
+    return veiculos_vias != NULL && chegadas_vias != NULL && movimentos_vias != NULL;
+}
+
+// Põe o veículo no fim da via a partir de 'agora', com o tempo de percurso
+// da sua velocidade aumentado pela ocupação da via, e devolve o tempo em
+// segundos em 'tempo'. Devolve false com a via lotada.
+bool entrarVia(uint32_t via, uint32_t veiculo, char movimento, float velocidade, TickType_t agora, uint16_t *tempo) {
+    via_t *estado = &vias[via];
+    float razao = (float)estado->ocupacao / estado->capacidade;
+    float segundos;
+    TickType_t chegada;
+    uint32_t posicao;
+
+    if (estado->ocupacao == estado->capacidade) {
+        return false;
+    }
+
+    segundos = calcularTempoPercurso(velocidade, rede.comprimento[via]) * (1 + BPR_ALFA * razao * razao * razao * razao);
+    if (segundos < TEMPO_MINIMO_VIA_MS / 1000.0f) {
+        segundos = TEMPO_MINIMO_VIA_MS / 1000.0f;
+    }
+    chegada = agora + pdMS_TO_TICKS((uint32_t)(segundos * 1000));
+
+    // Sem ultrapassagem: não chega antes de quem entrou primeiro
+    if (estado->em_transito > 0 && (TickType_t)(estado->ultima_chegada - chegada) < (portMAX_DELAY / 2)) {
+        chegada = estado->ultima_chegada;
+    }
+
+    posicao = estado->base + (estado->inicio + estado->em_transito) % estado->capacidade;
+    veiculos_vias[posicao] = veiculo;
+    chegadas_vias[posicao] = chegada;
+    movimentos_vias[posicao] = movimento;
+    estado->em_transito++;
+    estado->ocupacao++;
+    estado->ultima_chegada = chegada;
+    *tempo = (uint16_t)((chegada - agora) / configTICK_RATE_HZ);
+    return true;
+}
+
+// Informa o primeiro veículo em trânsito, se ele já chegou ao fim da via em 'agora'
+bool chegadaNaVia(uint32_t via, TickType_t agora, uint32_t *veiculo, char *movimento) {
+    via_t *estado = &vias[via];
+    uint32_t posicao = estado->base + estado->inicio;
+
+    if (estado->em_transito == 0 || (TickType_t)(agora - chegadas_vias[posicao]) >= (portMAX_DELAY / 2)) {
+        return false;
+    }
+    *veiculo = veiculos_vias[posicao];
+    *movimento = movimentos_vias[posicao];
+    return true;
+}
+
+// Retira do anel o primeiro veículo em trânsito, que passou para a fila do
+// cruzamento: ele continua ocupando a via até atravessar
+void retirarChegada(uint32_t via) {
+    via_t *estado = &vias[via];
+
+    estado->inicio = (estado->inicio + 1) % estado->capacidade;
+    estado->em_transito--;
+}
+
+// Libera o lugar de um veículo que deixou a via atravessando o cruzamento
+void sairVia(uint32_t via) {
+    vias[via].ocupacao--;
+}
@@ -0,0 +1,42 @@
+#ifndef VIAS_H
+#define VIAS_H
+
+// Estado das vias (trechos entre dois cruzamentos) durante a simulação: a
+// rede (rede.h) só descreve a geometria, e aqui ficam a capacidade, a
+// ocupação e os veículos em trânsito de cada via. Percorrer a via não ocupa
+// o cruzamento: o veículo só entra na fila da aproximação quando chega ao
+// fim dela, e o tempo de percurso cresce com a ocupação.
+//
+// Os veículos em trânsito ficam num anel por via, em ordem de chegada ao fim
+// dela: a via não tem ultrapassagem, então quem entra depois chega depois.
+// Quem avança a via é o dono do cruzamento de destino; as funções não têm
+// travas, e o modo de tarefas e o de agentes as protegem com seções críticas.
+
+#include <FreeRTOS.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ESPACO_VEICULO_M 7.5f       // Comprimento de via ocupado por veículo parado
+#define TEMPO_MINIMO_VIA_MS 2000    // Nenhuma via é percorrida em menos tempo (a janela do modo paralelo depende disso)
+#define BPR_ALFA 0.15f              // Função de atraso do Bureau of Public Roads: t = t0 * (1 + ALFA * (ocupação / capacidade)^4)
+
+typedef struct {
+    uint32_t base;          // Primeira posição do anel da via nos vetores comuns
+    uint32_t capacidade;    // Veículos que cabem na via
+    uint32_t ocupacao;      // Veículos na via, em trânsito ou parados na fila do cruzamento
+    uint32_t inicio;        // Posição do primeiro veículo em trânsito no anel
+    uint32_t em_transito;
+    TickType_t ultima_chegada;  // Chegada do último veículo que entrou
+} via_t;
+
+extern via_t *vias;                 // Estado de cada via da rede
+extern uint32_t *inicio_entradas;   // Primeira via de entrada de cada cruzamento em vias_entrada (num_cruzamentos + 1 posições)
+extern uint32_t *vias_entrada;      // Vias que chegam a cada cruzamento, em ordem de via
+
+bool criarVias(void);
+bool entrarVia(uint32_t via, uint32_t veiculo, char movimento, float velocidade, TickType_t agora, uint16_t *tempo);
+bool chegadaNaVia(uint32_t via, TickType_t agora, uint32_t *veiculo, char *movimento);
+void retirarChegada(uint32_t via);
+void sairVia(uint32_t via);
+
+#endif
@@ -58,6 +58,7 @@
 #include <sched.h>
 #include <signal.h>
 #include <errno.h>
+#include <stdlib.h>
 #include <sys/time.h>
 #include <time.h>
 #include <sys/times.h>
@@ -70,28 +71,63 @@
 #include "FreeRTOS.h"
 #include "task.h"
 /*-----------------------------------------------------------*/
-#ifndef MAX_NUMBER_OF_TASKS
-#define MAX_NUMBER_OF_TASKS 		( _POSIX_THREAD_THREADS_MAX )
+
+/* Thread states are allocated this many at a time, as tasks are created. */
+#ifndef portTHREAD_STATES_PER_CHUNK
+#define portTHREAD_STATES_PER_CHUNK	( 256 )
 #endif
-/*-----------------------------------------------------------*/
 
-/* Parameters to pass to the newly created pthread. */
-typedef struct XPARAMS
-{
-	pdTASK_CODE pxCode;
-	void *pvParams;
-} xParams;
+/* Stack size in bytes of the thread of a task created while no other size is
+set with vPortSetTaskStackSize(). */
+#ifndef portTASK_STACK_SIZE
+#define portTASK_STACK_SIZE			( 64 * 1024 )
+#endif
 
-/* Each task maintains its own interrupt status in the critical nesting variable. */
+/* Number of different stack sizes vPortReserveTaskThreads() keeps parked
+threads for. */
+#ifndef portTHREAD_POOLS
+#define portTHREAD_POOLS			( 4 )
+#endif
+/*-----------------------------------------------------------*/
+
+/* Each task maintains its own interrupt status in the critical nesting variable.
+pxPortInitialiseStack() returns a pointer to the task's thread state in place of
+a stack pointer, so as the first member of the TCB it is reached from a task
+handle in constant time.  Unused thread states are chained in a free list.  The
+thread of a task reads its entry point and parameters from here when the task
+first runs. */
 typedef struct THREAD_SUSPENSIONS
 {
 	pthread_t hThread;
-	xTaskHandle hTask;
 	unsigned portBASE_TYPE uxCriticalNesting;
+	struct THREAD_SUSPENSIONS *pxNextFree;
+	pdTASK_CODE pxCode;
+	void *pvParams;
 } xThreadState;
+
+/* Chunks are never moved or freed while the scheduler runs, so the pointers to
+thread states held in TCBs stay valid as the table grows. */
+typedef struct THREAD_STATE_CHUNK
+{
+	struct THREAD_STATE_CHUNK *pxNext;
+	xThreadState xThreads[ portTHREAD_STATES_PER_CHUNK ];
+} xThreadStateChunk;
+
+/* Threads started by vPortReserveTaskThreads() before any task needs them.
+Each waits in prvStartTask() with its thread state, chained through pxNextFree,
+until a task with the same stack size takes it. */
+typedef struct THREAD_POOL
+{
+	size_t xStackSize;
+	xThreadState *pxParked;
+} xThreadPool;
 /*-----------------------------------------------------------*/
 
-static xThreadState *pxThreads;
+static xThreadStateChunk *pxThreadChunks = NULL;
+static xThreadState *pxFreeThreads = NULL;
+static size_t xTaskStackSize = portTASK_STACK_SIZE;
+static void *pvTaskStack = NULL;
+static xThreadPool xThreadPools[ portTHREAD_POOLS ];
 static pthread_once_t hSigSetupThread = PTHREAD_ONCE_INIT;
 static pthread_attr_t xThreadAttributes;
 static pthread_mutex_t xSuspendResumeThreadMutex = PTHREAD_MUTEX_INITIALIZER;
@@ -104,7 +140,9 @@ static volatile portBASE_TYPE xSchedulerEnd = pdFALSE;
 static volatile portBASE_TYPE xInterruptsEnabled = pdTRUE;
 static volatile portBASE_TYPE xServicingTick = pdFALSE;
 static volatile portBASE_TYPE xPendYield = pdFALSE;
-static volatile portLONG lIndexOfLastAddedTask = 0;
+#if ( configUSE_VIRTUAL_TIME == 0 )
+static volatile portBASE_TYPE xTicksSuppressed = pdFALSE;
+#endif
 static volatile unsigned portBASE_TYPE uxCriticalNesting;
 /*-----------------------------------------------------------*/
 
@@ -112,17 +150,23 @@ static volatile unsigned portBASE_TYPE uxCriticalNesting;
  * Setup the timer to generate the tick interrupts.
  */
 static void prvSetupTimerInterrupt( void );
-static void *prvWaitForStart( void * pvParams );
+static void *prvStartTask( void * pvParams );
 static void prvSuspendSignalHandler(int sig);
 static void prvResumeSignalHandler(int sig);
 static void prvSetupSignalsAndSchedulerPolicy( void );
 static void prvSuspendThread( pthread_t xThreadId );
-static void prvResumeThread( pthread_t xThreadId );
-static pthread_t prvGetThreadHandle( xTaskHandle hTask );
-static portLONG prvGetFreeThreadState( void );
-static void prvSetTaskCriticalNesting( pthread_t xThreadId, unsigned portBASE_TYPE uxNesting );
-static unsigned portBASE_TYPE prvGetTaskCriticalNesting( pthread_t xThreadId );
-static void prvDeleteThread( void *xThreadId );
+static void prvResumeThread( xThreadState *pxThread );
+static xThreadState *prvGetThreadState( xTaskHandle hTask );
+static xThreadState *prvGetFreeThreadState( void );
+static void prvReleaseThreadState( xThreadState *pxThread );
+static void prvAddThreadStateChunk( void );
+static portBASE_TYPE prvCreateThread( xThreadState *pxThread );
+static xThreadPool *prvGetThreadPool( size_t xStackSize, portBASE_TYPE xAdd );
+static portBASE_TYPE prvTickShouldAdvance( void );
+static void prvTickNotServiced( void );
+#if ( configUSE_TICKLESS_IDLE == 1 ) && ( configUSE_VIRTUAL_TIME == 0 )
+static TickType_t prvSleepWithoutTicks( TickType_t xExpectedIdleTime );
+#endif
 /*-----------------------------------------------------------*/
 
 /*
@@ -142,8 +186,8 @@ void vPortStartFirstTask( void );
  */
 portSTACK_TYPE *pxPortInitialiseStack( portSTACK_TYPE *pxTopOfStack, pdTASK_CODE pxCode, void *pvParameters )
 {
-/* Should actually keep this struct on the stack. */
-xParams *pxThisThreadParams = pvPortMalloc( sizeof( xParams ) );
+xThreadState *pxThread = NULL;
+xThreadPool *pxPool;
 
 	(void)pthread_once( &hSigSetupThread, prvSetupSignalsAndSchedulerPolicy );
 
@@ -152,33 +196,42 @@ xParams *pxThisThreadParams = pvPortMalloc( sizeof( xParams ) );
 		hMainThread = pthread_self();
 	}
 
-	/* No need to join the threads. */
-	pthread_attr_init( &xThreadAttributes );
-	pthread_attr_setdetachstate( &xThreadAttributes, PTHREAD_CREATE_DETACHED );
-
-	/* Add the task parameters. */
-	pxThisThreadParams->pxCode = pxCode;
-	pxThisThreadParams->pvParams = pvParameters;
-
+	/* A thread parked by vPortReserveTaskThreads() is taken if one has the
+	stack the task asks for; otherwise the task's thread is started here.
+	Tasks are only ever created from task context, never from the tick
+	handler. */
 	vPortEnterCritical();
 
-	lIndexOfLastAddedTask = prvGetFreeThreadState();
+	if ( NULL == pvTaskStack )
+	{
+		pxPool = prvGetThreadPool( xTaskStackSize, pdFALSE );
+		if ( ( NULL != pxPool ) && ( NULL != pxPool->pxParked ) )
+		{
+			pxThread = pxPool->pxParked;
+			pxPool->pxParked = pxThread->pxNextFree;
+		}
+	}
 
-	/* Create the new pThread. */
-	if ( 0 == pthread_mutex_lock( &xSingleThreadMutex ) )
+	if ( NULL == pxThread )
 	{
-		xSentinel = 0;
-		if ( 0 != pthread_create( &( pxThreads[ lIndexOfLastAddedTask ].hThread ), &xThreadAttributes, prvWaitForStart, (void *)pxThisThreadParams ) )
+		pxThread = prvGetFreeThreadState();
+		if ( ( NULL != pxThread ) && ( 0 != prvCreateThread( pxThread ) ) )
 		{
 			/* Thread create failed, signal the failure */
-			pxTopOfStack = 0;
+			prvReleaseThreadState( pxThread );
+			pxThread = NULL;
 		}
+	}
 
-		/* Wait until the task suspends. */
-		(void)pthread_mutex_unlock( &xSingleThreadMutex );
-		while ( xSentinel == 0 );
-		vPortExitCritical();
+	/* The thread reads these after its first SIG_RESUME. */
+	if ( NULL != pxThread )
+	{
+		pxThread->pxCode = pxCode;
+		pxThread->pvParams = pvParameters;
 	}
+	pxTopOfStack = ( portSTACK_TYPE * )pxThread;
+
+	vPortExitCritical();
 
 	return pxTopOfStack;
 }
@@ -193,7 +246,7 @@ void vPortStartFirstTask( void )
 	vPortEnableInterrupts();
 
 	/* Start the first task. */
-	prvResumeThread( prvGetThreadHandle( xTaskGetCurrentTaskHandle() ) );
+	prvResumeThread( prvGetThreadState( xTaskGetCurrentTaskHandle() ) );
 }
 /*-----------------------------------------------------------*/
 
@@ -207,6 +260,7 @@ int iSignal;
 sigset_t xSignals;
 sigset_t xSignalToBlock;
 sigset_t xSignalsBlocked;
+xThreadStateChunk *pxChunk;
 portLONG lIndex;
 
 	/* Establish the signals to block before they are needed. */
@@ -215,9 +269,12 @@ portLONG lIndex;
 	/* Block until the end */
 	(void)pthread_sigmask( SIG_SETMASK, &xSignalToBlock, &xSignalsBlocked );
 
-	for ( lIndex = 0; lIndex < MAX_NUMBER_OF_TASKS; lIndex++ )
+	for ( pxChunk = pxThreadChunks; NULL != pxChunk; pxChunk = pxChunk->pxNext )
 	{
-		pxThreads[ lIndex ].uxCriticalNesting = 0;
+		for ( lIndex = 0; lIndex < portTHREAD_STATES_PER_CHUNK; lIndex++ )
+		{
+			pxChunk->xThreads[ lIndex ].uxCriticalNesting = 0;
+		}
 	}
 
 	/* Start the timer that generates the tick ISR.  Interrupts are disabled
@@ -243,7 +300,14 @@ portLONG lIndex;
 	/* Cleanup the mutexes */
 	xResult = pthread_mutex_destroy( &xSuspendResumeThreadMutex );
 	xResult = pthread_mutex_destroy( &xSingleThreadMutex );
-	vPortFree( (void *)pxThreads );
+	while ( NULL != pxThreadChunks )
+	{
+		pxChunk = pxThreadChunks;
+		pxThreadChunks = pxChunk->pxNext;
+		/* Not vPortFree(): with heap_3 it would resume the scheduler that has
+		just been torn down. */
+		free( (void *)pxChunk );
+	}
 
 	/* Should not get here! */
 	return xResult;
@@ -252,16 +316,20 @@ portLONG lIndex;
 
 void vPortEndScheduler( void )
 {
+xThreadStateChunk *pxChunk;
 portBASE_TYPE xNumberOfThreads;
 portBASE_TYPE xResult;
-	for ( xNumberOfThreads = 0; xNumberOfThreads < MAX_NUMBER_OF_TASKS; xNumberOfThreads++ )
+	for ( pxChunk = pxThreadChunks; NULL != pxChunk; pxChunk = pxChunk->pxNext )
 	{
-		if ( ( pthread_t )NULL != pxThreads[ xNumberOfThreads ].hThread )
+		for ( xNumberOfThreads = 0; xNumberOfThreads < portTHREAD_STATES_PER_CHUNK; xNumberOfThreads++ )
 		{
-			/* Kill all of the threads, they are in the detached state. */
-			xResult = pthread_cancel( pxThreads[ xNumberOfThreads ].hThread );
-            if (xResult)
-                printf("pthread_cancel error!\n");
+			if ( ( pthread_t )NULL != pxChunk->xThreads[ xNumberOfThreads ].hThread )
+			{
+				/* Kill all of the threads, they are in the detached state. */
+				xResult = pthread_cancel( pxChunk->xThreads[ xNumberOfThreads ].hThread );
+				if (xResult)
+					printf("pthread_cancel error!\n");
+			}
 		}
 	}
 
@@ -312,24 +380,24 @@ void vPortExitCritical( void )
 
 void vPortYield( void )
 {
-pthread_t xTaskToSuspend;
-pthread_t xTaskToResume;
+xThreadState *pxTaskToSuspend;
+xThreadState *pxTaskToResume;
 
 	if ( 0 == pthread_mutex_lock( &xSingleThreadMutex ) )
 	{
-		xTaskToSuspend = prvGetThreadHandle( xTaskGetCurrentTaskHandle() );
+		pxTaskToSuspend = prvGetThreadState( xTaskGetCurrentTaskHandle() );
 
 		vTaskSwitchContext();
 
-		xTaskToResume = prvGetThreadHandle( xTaskGetCurrentTaskHandle() );
-		if ( xTaskToSuspend != xTaskToResume )
+		pxTaskToResume = prvGetThreadState( xTaskGetCurrentTaskHandle() );
+		if ( pxTaskToSuspend != pxTaskToResume )
 		{
 			/* Remember and switch the critical nesting. */
-			prvSetTaskCriticalNesting( xTaskToSuspend, uxCriticalNesting );
-			uxCriticalNesting = prvGetTaskCriticalNesting( xTaskToResume );
+			pxTaskToSuspend->uxCriticalNesting = uxCriticalNesting;
+			uxCriticalNesting = pxTaskToResume->uxCriticalNesting;
 			/* Switch tasks. */
-			prvResumeThread( xTaskToResume );
-			prvSuspendThread( xTaskToSuspend );
+			prvResumeThread( pxTaskToResume );
+			prvSuspendThread( pxTaskToSuspend->hThread );
 		}
 		else
 		{
@@ -401,8 +469,8 @@ portTickType xMicroSeconds = portTICK_PERIOD_MS * 1000;
 
 void vPortSystemTickHandler( int sig )
 {
-pthread_t xTaskToSuspend;
-pthread_t xTaskToResume;
+xThreadState *pxTaskToSuspend;
+xThreadState *pxTaskToResume;
 
     (void)(sig);
 	if ( ( pdTRUE == xInterruptsEnabled ) && ( pdTRUE != xServicingTick ) )
@@ -411,26 +479,31 @@ pthread_t xTaskToResume;
 		{
 			xServicingTick = pdTRUE;
 
-			xTaskToSuspend = prvGetThreadHandle( xTaskGetCurrentTaskHandle() );
-			/* Tick Increment. */
-			xTaskIncrementTick();
+			pxTaskToSuspend = prvGetThreadState( xTaskGetCurrentTaskHandle() );
+			/* Tick Increment.  A tick that does not advance time does not
+			time slice either, so in virtual time the interleaving of tasks
+			does not depend on the wall clock and runs are reproducible. */
+			if ( pdTRUE == prvTickShouldAdvance() )
+			{
+				xTaskIncrementTick();
 
-			/* Select Next Task. */
+				/* Select Next Task. */
 #if ( configUSE_PREEMPTION == 1 )
-			vTaskSwitchContext();
+				vTaskSwitchContext();
 #endif
-			xTaskToResume = prvGetThreadHandle( xTaskGetCurrentTaskHandle() );
+			}
+			pxTaskToResume = prvGetThreadState( xTaskGetCurrentTaskHandle() );
 
 			/* The only thread that can process this tick is the running thread. */
-			if ( xTaskToSuspend != xTaskToResume )
+			if ( pxTaskToSuspend != pxTaskToResume )
 			{
 				/* Remember and switch the critical nesting. */
-				prvSetTaskCriticalNesting( xTaskToSuspend, uxCriticalNesting );
-				uxCriticalNesting = prvGetTaskCriticalNesting( xTaskToResume );
+				pxTaskToSuspend->uxCriticalNesting = uxCriticalNesting;
+				uxCriticalNesting = pxTaskToResume->uxCriticalNesting;
 				/* Resume next task. */
-				prvResumeThread( xTaskToResume );
+				prvResumeThread( pxTaskToResume );
 				/* Suspend the current task. */
-				prvSuspendThread( xTaskToSuspend );
+				prvSuspendThread( pxTaskToSuspend->hThread );
 			}
 			else
 			{
@@ -441,82 +514,253 @@ pthread_t xTaskToResume;
 		}
 		else
 		{
-			xPendYield = pdTRUE;
+			prvTickNotServiced();
 		}
 	}
 	else
 	{
-		xPendYield = pdTRUE;
+		prvTickNotServiced();
 	}
 }
 /*-----------------------------------------------------------*/
 
-void vPortForciblyEndThread( void *pxTaskToDelete )
+void prvTickNotServiced( void )
 {
-xTaskHandle hTaskToDelete = ( xTaskHandle )pxTaskToDelete;
-pthread_t xTaskToDelete;
-pthread_t xTaskToResume;
-portBASE_TYPE xResult;
+	/* The tick is lost.  In real time it still asks for the switch it may
+	have made necessary; in virtual time it asks for nothing, otherwise a task
+	would be rotated out at a point that depends on the wall clock and runs
+	would not be reproducible. */
+#if ( configUSE_VIRTUAL_TIME == 0 )
+	xPendYield = pdTRUE;
+#endif
+}
+/*-----------------------------------------------------------*/
 
-	if ( 0 == pthread_mutex_lock( &xSingleThreadMutex ) )
+portBASE_TYPE prvTickShouldAdvance( void )
+{
+#if ( configUSE_VIRTUAL_TIME == 1 )
+	/* Virtual time stands still while any task other than idle is running.
+	The periodic tick is then only needed when the next unblock time is too
+	close for vPortSuppressTicksAndSleep() to jump to it.  While the idle task
+	has the scheduler suspended it may be about to jump, and a tick pended then
+	would be added on top of the jump. */
+	return ( ( xTaskGetCurrentTaskHandle() == xTaskGetIdleTaskHandle() ) &&
+			 ( taskSCHEDULER_SUSPENDED != xTaskGetSchedulerState() ) ) ? pdTRUE : pdFALSE;
+#else
+	/* A tick still queued when the idle task stopped the timer is already
+	counted by the sleep. */
+	return ( pdFALSE == xTicksSuppressed ) ? pdTRUE : pdFALSE;
+#endif
+}
+/*-----------------------------------------------------------*/
+
+void vPortWaitForTick( void )
+{
+#if ( configUSE_VIRTUAL_TIME == 0 )
+sigset_t xTick, xPrevious, xWait;
+
+	/* Only the idle task's thread waits here; the mask is per thread.  A
+	tick that switches away suspends this thread inside the handler, and a
+	tick lost to xSingleThreadMutex leaves xPendYield set for the idle task
+	to yield itself, so the wait is skipped then.  SIG_TICK stays blocked
+	from the check to sigsuspend() so that no tick slips in between. */
+	sigemptyset( &xTick );
+	sigaddset( &xTick, SIG_TICK );
+	( void )pthread_sigmask( SIG_BLOCK, &xTick, &xPrevious );
+	if ( pdFALSE == xPendYield )
 	{
-		xTaskToDelete = prvGetThreadHandle( hTaskToDelete );
-		xTaskToResume = prvGetThreadHandle( xTaskGetCurrentTaskHandle() );
+		xWait = xPrevious;
+		sigdelset( &xWait, SIG_TICK );
+		( void )sigsuspend( &xWait );
+	}
+	( void )pthread_sigmask( SIG_SETMASK, &xPrevious, NULL );
+#endif
+}
+/*-----------------------------------------------------------*/
 
-		if ( xTaskToResume == xTaskToDelete )
-		{
-			/* This is a suicidal thread, need to select a different task to run. */
-			vTaskSwitchContext();
-			xTaskToResume = prvGetThreadHandle( xTaskGetCurrentTaskHandle() );
-		}
+#if ( configUSE_TICKLESS_IDLE == 1 )
 
-		if ( pthread_self() != xTaskToDelete )
-		{
-			/* Cancelling a thread that is not me. */
-			if ( xTaskToDelete != ( pthread_t )NULL )
-			{
-				/* Send a signal to wake the task so that it definitely cancels. */
-				pthread_testcancel();
-				xResult = pthread_cancel( xTaskToDelete );
-                if (xResult)
-                    printf("pthread_cancel error!\n");
-				/* Pthread Clean-up function will note the cancellation. */
-			}
-			(void)pthread_mutex_unlock( &xSingleThreadMutex );
-		}
-		else
+void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
+{
+	/* Called by the idle task with the scheduler suspended. */
+	if ( eStandardSleep == eTaskConfirmSleepModeStatus() )
+	{
+#if ( configUSE_VIRTUAL_TIME == 1 )
+		/* Every task is blocked, so nothing can happen before the next unblock
+		time: step to the tick just before it and pend the final tick, which
+		xTaskResumeAll() processes to unblock the waiting tasks. */
+		vTaskStepTick( xExpectedIdleTime - 1 );
+		( void )xTaskIncrementTick();
+#else
+		vTaskStepTick( prvSleepWithoutTicks( xExpectedIdleTime ) );
+#endif
+	}
+}
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_VIRTUAL_TIME == 0 )
+
+TickType_t prvSleepWithoutTicks( TickType_t xExpectedIdleTime )
+{
+const long long llTickPeriod = portTICK_PERIOD_MS * 1000000LL;
+struct itimerval xTimer, xStopped = { { 0, 0 }, { 0, 0 } };
+struct timespec xStart, xNow, xDelay;
+long long llFirstTick, llWakeTime, llElapsed, llNextTick;
+TickType_t xTicks;
+
+	/* Stop the tick timer, noting how long was left until the next tick. */
+	xTicksSuppressed = pdTRUE;
+	( void )setitimer( TIMER_TYPE, &xStopped, &xTimer );
+	( void )clock_gettime( CLOCK_MONOTONIC, &xStart );
+	llFirstTick = xTimer.it_value.tv_sec * 1000000000LL + xTimer.it_value.tv_usec * 1000LL;
+	if ( 0 == llFirstTick )
+	{
+		llFirstTick = llTickPeriod;
+	}
+
+	/* Threads the scheduler does not run, such as the application's worker
+	and writer threads, must not call the kernel, so with every task blocked
+	only a tick can ready one.  Sleep until the tick before the next unblock
+	time; the timer restarted afterwards delivers the last tick.  The other
+	task threads are parked in sigwait() and the tick signal, if one is still
+	queued, is ignored through xTicksSuppressed. */
+	llWakeTime = llFirstTick + ( long long )( xExpectedIdleTime - 2 ) * llTickPeriod;
+	for ( ;; )
+	{
+		( void )clock_gettime( CLOCK_MONOTONIC, &xNow );
+		llElapsed = ( xNow.tv_sec - xStart.tv_sec ) * 1000000000LL + ( xNow.tv_nsec - xStart.tv_nsec );
+		if ( llElapsed >= llWakeTime )
 		{
-			/* Resume the other thread. */
-			prvResumeThread( xTaskToResume );
-			/* Pthread Clean-up function will note the cancellation. */
-			/* Release the execution. */
-			uxCriticalNesting = 0;
-			vPortEnableInterrupts();
-			(void)pthread_mutex_unlock( &xSingleThreadMutex );
-			/* Commit suicide */
-			pthread_exit( (void *)1 );
+			break;
 		}
+		xDelay.tv_sec = ( time_t )( ( llWakeTime - llElapsed ) / 1000000000LL );
+		xDelay.tv_nsec = ( long )( ( llWakeTime - llElapsed ) % 1000000000LL );
+		( void )nanosleep( &xDelay, NULL );
+	}
+
+	/* Count the ticks that went by, no further than the tick before the next
+	unblock time, and restart the timer in step with the ticks it would have
+	delivered. */
+	xTicks = ( TickType_t )( 1 + ( llElapsed - llFirstTick ) / llTickPeriod );
+	if ( xTicks > xExpectedIdleTime - 1 )
+	{
+		xTicks = xExpectedIdleTime - 1;
+	}
+	llNextTick = llFirstTick + ( long long )xTicks * llTickPeriod - llElapsed;
+	if ( llNextTick < 1000LL )
+	{
+		llNextTick = 1000LL;
 	}
+
+	xTimer.it_interval.tv_sec = 0;
+	xTimer.it_interval.tv_usec = ( suseconds_t )( llTickPeriod / 1000LL );
+	xTimer.it_value.tv_sec = ( time_t )( llNextTick / 1000000000LL );
+	xTimer.it_value.tv_usec = ( suseconds_t )( ( llNextTick % 1000000000LL ) / 1000LL );
+	xTicksSuppressed = pdFALSE;
+	if ( 0 != setitimer( TIMER_TYPE, &xTimer, NULL ) )
+	{
+		printf( "Set Timer problem.\n" );
+	}
+
+	return xTicks;
 }
+
+#endif /* configUSE_VIRTUAL_TIME */
+
+#endif /* configUSE_TICKLESS_IDLE */
 /*-----------------------------------------------------------*/
 
-void *prvWaitForStart( void * pvParams )
+void vPortForciblyEndThread( void *pxTaskToDelete )
 {
-xParams * pxParams = ( xParams * )pvParams;
-pdTASK_CODE pvCode = pxParams->pxCode;
-void * pParams = pxParams->pvParams;
-	vPortFree( pvParams );
+xThreadState *pxTaskToResume;
 
-	pthread_cleanup_push( prvDeleteThread, (void *)pthread_self() );
+	/* A task deleted by another task has already had its thread cancelled by
+	vPortCleanUpTCB(), and its TCB has been freed.  Only a task deleting
+	itself is left to deal with here. */
+	if ( ( xTaskHandle )pxTaskToDelete != xTaskGetCurrentTaskHandle() )
+	{
+		return;
+	}
 
 	if ( 0 == pthread_mutex_lock( &xSingleThreadMutex ) )
 	{
-		prvSuspendThread( pthread_self() );
+		/* The idle task frees the TCB later on; detach the thread state from
+		it now so that the slot can be reused straight away. */
+		prvReleaseThreadState( prvGetThreadState( ( xTaskHandle )pxTaskToDelete ) );
+		*( xThreadState ** )pxTaskToDelete = NULL;
+
+		/* This is a suicidal thread, need to select a different task to run. */
+		vTaskSwitchContext();
+		pxTaskToResume = prvGetThreadState( xTaskGetCurrentTaskHandle() );
+
+		/* Resume the other thread. */
+		uxCriticalNesting = pxTaskToResume->uxCriticalNesting;
+		prvResumeThread( pxTaskToResume );
+		/* Release the execution. */
+		(void)pthread_mutex_unlock( &xSingleThreadMutex );
+		/* Commit suicide */
+		pthread_exit( (void *)1 );
 	}
+}
+/*-----------------------------------------------------------*/
 
-	pvCode( pParams );
+void vPortCleanUpTCB( void *pxTCB )
+{
+xThreadState *pxThread = prvGetThreadState( ( xTaskHandle )pxTCB );
+portBASE_TYPE xResult;
+
+	/* Called before the TCB is freed.  A task that deleted itself has
+	already released its thread state. */
+	if ( NULL != pxThread )
+	{
+		/* Cancelling a thread that is not me; it is suspended waiting for
+		SIG_RESUME, which is a cancellation point. */
+		xResult = pthread_cancel( pxThread->hThread );
+		if (xResult)
+			printf("pthread_cancel error!\n");
+		prvReleaseThreadState( pxThread );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void *prvStartTask( void * pvParams )
+{
+xThreadState *pxThread = ( xThreadState * )pvParams;
+sigset_t xSignals;
+int iSignal;
+
+	/* Wait for the scheduler to run the task for the first time.  Every
+	signal is blocked, so a SIG_RESUME sent before the thread gets here stays
+	pending until the sigwait(). */
+	sigemptyset( &xSignals );
+	sigaddset( &xSignals, SIG_RESUME );
+	if ( 0 != sigwait( &xSignals, &iSignal ) )
+	{
+		printf( "ST: Sw %d\n", iSignal );
+	}
+
+	/* As in prvResumeSignalHandler(), wait for the thread that resumed this
+	one to finish suspending. */
+	if ( 0 == pthread_mutex_lock( &xSingleThreadMutex ) )
+	{
+		(void)pthread_mutex_unlock( &xSingleThreadMutex );
+	}
+
+	sigemptyset( &xSignals );
+	(void)pthread_sigmask( SIG_SETMASK, &xSignals, NULL );
+
+	/* From here on the task behaves as a resumed one. */
+	if ( uxCriticalNesting == 0 )
+	{
+		vPortEnableInterrupts();
+	}
+	else
+	{
+		vPortDisableInterrupts();
+	}
+
+	pxThread->pxCode( pxThread->pvParams );
 
-	pthread_cleanup_pop( 1 );
 	return (void *)NULL;
 }
 /*-----------------------------------------------------------*/
@@ -585,14 +829,14 @@ void prvResumeSignalHandler(int sig)
 }
 /*-----------------------------------------------------------*/
 
-void prvResumeThread( pthread_t xThreadId )
+void prvResumeThread( xThreadState *pxThread )
 {
 portBASE_TYPE xResult;
 	if ( 0 == pthread_mutex_lock( &xSuspendResumeThreadMutex ) )
 	{
-		if ( pthread_self() != xThreadId )
+		if ( pthread_self() != pxThread->hThread )
 		{
-			xResult = pthread_kill( xThreadId, SIG_RESUME );
+			xResult = pthread_kill( pxThread->hThread, SIG_RESUME );
             if (xResult)
                 printf("pthread_kill error!\n");
 		}
@@ -616,15 +860,10 @@ int iSchedulerPriority;
 	iResult = pthread_setschedparam( pthread_self(), iPolicy, &iSchedulerPriority );		*/
 
 struct sigaction sigsuspendself, sigresume, sigtick;
-portLONG lIndex;
 
-	pxThreads = ( xThreadState *)pvPortMalloc( sizeof( xThreadState ) * MAX_NUMBER_OF_TASKS );
-	for ( lIndex = 0; lIndex < MAX_NUMBER_OF_TASKS; lIndex++ )
-	{
-		pxThreads[ lIndex ].hThread = ( pthread_t )NULL;
-		pxThreads[ lIndex ].hTask = ( xTaskHandle )NULL;
-		pxThreads[ lIndex ].uxCriticalNesting = 0;
-	}
+	/* No need to join the threads. */
+	pthread_attr_init( &xThreadAttributes );
+	pthread_attr_setdetachstate( &xThreadAttributes, PTHREAD_CREATE_DETACHED );
 
 	sigsuspendself.sa_flags = 0;
 	sigsuspendself.sa_handler = prvSuspendSignalHandler;
@@ -654,112 +893,185 @@ portLONG lIndex;
 }
 /*-----------------------------------------------------------*/
 
-pthread_t prvGetThreadHandle( xTaskHandle hTask )
+xThreadState *prvGetThreadState( xTaskHandle hTask )
 {
-pthread_t hThread = ( pthread_t )NULL;
-portLONG lIndex;
-	for ( lIndex = 0; lIndex < MAX_NUMBER_OF_TASKS; lIndex++ )
-	{
-		if ( pxThreads[ lIndex ].hTask == hTask )
-		{
-			hThread = pxThreads[ lIndex ].hThread;
-			break;
-		}
-	}
-	return hThread;
+	/* pxTopOfStack, the first member of the TCB, holds the thread state. */
+	return *( xThreadState ** )hTask;
 }
 /*-----------------------------------------------------------*/
 
-portLONG prvGetFreeThreadState( void )
+xThreadState *prvGetFreeThreadState( void )
 {
-portLONG lIndex;
-	for ( lIndex = 0; lIndex < MAX_NUMBER_OF_TASKS; lIndex++ )
+xThreadState *pxThread;
+
+	if ( NULL == pxFreeThreads )
 	{
-		if ( pxThreads[ lIndex ].hThread == ( pthread_t )NULL )
-		{
-			break;
-		}
+		prvAddThreadStateChunk();
 	}
 
-	if ( MAX_NUMBER_OF_TASKS == lIndex )
+	pxThread = pxFreeThreads;
+	if ( NULL == pxThread )
 	{
-		printf( "No more free threads, please increase the maximum.\n" );
-		lIndex = 0;
+		printf( "No more memory for thread states.\n" );
 		vPortEndScheduler();
 	}
+	else
+	{
+		pxFreeThreads = pxThread->pxNextFree;
+	}
+
+	return pxThread;
+}
+/*-----------------------------------------------------------*/
 
-	return lIndex;
+void prvReleaseThreadState( xThreadState *pxThread )
+{
+	pxThread->hThread = ( pthread_t )NULL;
+	pxThread->uxCriticalNesting = 0;
+	pxThread->pxNextFree = pxFreeThreads;
+	pxFreeThreads = pxThread;
 }
 /*-----------------------------------------------------------*/
 
-void prvSetTaskCriticalNesting( pthread_t xThreadId, unsigned portBASE_TYPE uxNesting )
+void prvAddThreadStateChunk( void )
 {
+xThreadStateChunk *pxChunk = ( xThreadStateChunk * )malloc( sizeof( xThreadStateChunk ) );
 portLONG lIndex;
-	for ( lIndex = 0; lIndex < MAX_NUMBER_OF_TASKS; lIndex++ )
+
+	if ( NULL != pxChunk )
 	{
-		if ( pxThreads[ lIndex ].hThread == xThreadId )
+		for ( lIndex = portTHREAD_STATES_PER_CHUNK - 1; lIndex >= 0; lIndex-- )
 		{
-			pxThreads[ lIndex ].uxCriticalNesting = uxNesting;
-			break;
+			pxChunk->xThreads[ lIndex ].hThread = ( pthread_t )NULL;
+			pxChunk->xThreads[ lIndex ].uxCriticalNesting = 0;
+			pxChunk->xThreads[ lIndex ].pxNextFree = pxFreeThreads;
+			pxFreeThreads = &( pxChunk->xThreads[ lIndex ] );
 		}
+		pxChunk->pxNext = pxThreadChunks;
+		pxThreadChunks = pxChunk;
 	}
 }
 /*-----------------------------------------------------------*/
 
-unsigned portBASE_TYPE prvGetTaskCriticalNesting( pthread_t xThreadId )
+portBASE_TYPE prvCreateThread( xThreadState *pxThread )
 {
-unsigned portBASE_TYPE uxNesting = 0;
-portLONG lIndex;
-	for ( lIndex = 0; lIndex < MAX_NUMBER_OF_TASKS; lIndex++ )
+pthread_attr_t xAttributes;
+sigset_t xSignals, xPrevious;
+portBASE_TYPE xResult;
+
+	/* The new thread inherits a mask with every signal blocked and waits in
+	prvStartTask() for the first SIG_RESUME, so starting it does not wait for
+	it to run. */
+	sigfillset( &xSignals );
+	(void)pthread_sigmask( SIG_SETMASK, &xSignals, &xPrevious );
+	if ( NULL == pvTaskStack )
 	{
-		if ( pxThreads[ lIndex ].hThread == xThreadId )
-		{
-			uxNesting = pxThreads[ lIndex ].uxCriticalNesting;
-			break;
-		}
+		pthread_attr_setstacksize( &xThreadAttributes, xTaskStackSize );
+		xResult = pthread_create( &( pxThread->hThread ), &xThreadAttributes, prvStartTask, (void *)pxThread );
+	}
+	else
+	{
+		/* The stack address stays in the attributes it is set in, so a
+		task with its own stack gets attributes of its own. */
+		pthread_attr_init( &xAttributes );
+		pthread_attr_setdetachstate( &xAttributes, PTHREAD_CREATE_DETACHED );
+		pthread_attr_setstack( &xAttributes, pvTaskStack, xTaskStackSize );
+		xResult = pthread_create( &( pxThread->hThread ), &xAttributes, prvStartTask, (void *)pxThread );
+		pthread_attr_destroy( &xAttributes );
 	}
-	return uxNesting;
+	(void)pthread_sigmask( SIG_SETMASK, &xPrevious, NULL );
+
+	return xResult;
 }
 /*-----------------------------------------------------------*/
 
-void prvDeleteThread( void *xThreadId )
+xThreadPool *prvGetThreadPool( size_t xStackSize, portBASE_TYPE xAdd )
 {
 portLONG lIndex;
-	for ( lIndex = 0; lIndex < MAX_NUMBER_OF_TASKS; lIndex++ )
+
+	for ( lIndex = 0; lIndex < portTHREAD_POOLS; lIndex++ )
+	{
+		if ( xThreadPools[ lIndex ].xStackSize == xStackSize )
+		{
+			return &( xThreadPools[ lIndex ] );
+		}
+	}
+
+	if ( pdFALSE != xAdd )
 	{
-		if ( pxThreads[ lIndex ].hThread == ( pthread_t )xThreadId )
+		for ( lIndex = 0; lIndex < portTHREAD_POOLS; lIndex++ )
 		{
-			pxThreads[ lIndex ].hThread = (pthread_t)NULL;
-			pxThreads[ lIndex ].hTask = (xTaskHandle)NULL;
-			if ( pxThreads[ lIndex ].uxCriticalNesting > 0 )
+			if ( 0 == xThreadPools[ lIndex ].xStackSize )
 			{
-				uxCriticalNesting = 0;
-				vPortEnableInterrupts();
+				xThreadPools[ lIndex ].xStackSize = xStackSize;
+				return &( xThreadPools[ lIndex ] );
 			}
-			pxThreads[ lIndex ].uxCriticalNesting = 0;
-			break;
 		}
 	}
+
+	return NULL;
 }
 /*-----------------------------------------------------------*/
 
-void vPortAddTaskHandle( void *pxTaskHandle )
+void vPortReserveTaskThreads( unsigned portBASE_TYPE uxThreads )
 {
-portLONG lIndex;
+xThreadPool *pxPool;
+xThreadState *pxThread;
+
+	(void)pthread_once( &hSigSetupThread, prvSetupSignalsAndSchedulerPolicy );
+
+	/* Threads running on memory set with vPortSetTaskStack() are not pooled:
+	each task brings its own stack. */
+	if ( NULL != pvTaskStack )
+	{
+		return;
+	}
+
+	vPortEnterCritical();
 
-	pxThreads[ lIndexOfLastAddedTask ].hTask = ( xTaskHandle )pxTaskHandle;
-	for ( lIndex = 0; lIndex < MAX_NUMBER_OF_TASKS; lIndex++ )
+	pxPool = prvGetThreadPool( xTaskStackSize, pdTRUE );
+	while ( ( NULL != pxPool ) && ( uxThreads > 0 ) )
 	{
-		if ( pxThreads[ lIndex ].hThread == pxThreads[ lIndexOfLastAddedTask ].hThread )
+		pxThread = prvGetFreeThreadState();
+		if ( NULL == pxThread )
 		{
-			if ( pxThreads[ lIndex ].hTask != pxThreads[ lIndexOfLastAddedTask ].hTask )
-			{
-				pxThreads[ lIndex ].hThread = ( pthread_t )NULL;
-				pxThreads[ lIndex ].hTask = NULL;
-				pxThreads[ lIndex ].uxCriticalNesting = 0;
-			}
+			break;
 		}
+		if ( 0 != prvCreateThread( pxThread ) )
+		{
+			/* The tasks that find the pool empty start their own threads. */
+			prvReleaseThreadState( pxThread );
+			break;
+		}
+		pxThread->pxNextFree = pxPool->pxParked;
+		pxPool->pxParked = pxThread;
+		uxThreads--;
+	}
+
+	vPortExitCritical();
+}
+/*-----------------------------------------------------------*/
+
+void vPortSetTaskStackSize( size_t xStackSize )
+{
+	if ( 0 == xStackSize )
+	{
+		xTaskStackSize = portTASK_STACK_SIZE;
 	}
+	else if ( xStackSize < PTHREAD_STACK_MIN )
+	{
+		xTaskStackSize = PTHREAD_STACK_MIN;
+	}
+	else
+	{
+		xTaskStackSize = xStackSize;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortSetTaskStack( void *pvStack )
+{
+	pvTaskStack = pvStack;
 }
 /*-----------------------------------------------------------*/
 
@@ -93,13 +93,43 @@ extern void vPortExitCritical( void );
 
 #define portNOP()
 
+/* Stack size in bytes for the tasks created from now on; 0 restores the
+default, portTASK_STACK_SIZE. */
+extern void vPortSetTaskStackSize( size_t xStackSize );
+
+/* Memory of the size set with vPortSetTaskStackSize() that the tasks created
+from now on run on, in place of a stack the port allocates; NULL restores the
+allocation.  The memory must outlive the task. */
+extern void vPortSetTaskStack( void *pvStack );
+
+/* Starts uxThreads task threads with the stack size set with
+vPortSetTaskStackSize() and parks them; the tasks created later with that size
+and no vPortSetTaskStack() memory take one each in place of starting a thread.
+Call it from main() or a task, never from an interrupt. */
+extern void vPortReserveTaskThreads( unsigned portBASE_TYPE uxThreads );
+
 #define portOUTPUT_BYTE( a, b )
 
 extern void vPortForciblyEndThread( void *pxTaskToDelete );
 #define traceTASK_DELETE( pxTaskToDelete )		vPortForciblyEndThread( pxTaskToDelete )
 
-extern void vPortAddTaskHandle( void *pxTaskHandle );
-#define traceTASK_CREATE( pxNewTCB )			vPortAddTaskHandle( pxNewTCB )
+/* Cancels the thread of a task deleted by another task before its TCB is freed. */
+extern void vPortCleanUpTCB( void *pxTCB );
+#define portCLEAN_UP_TCB( pxTCB )				vPortCleanUpTCB( pxTCB )
+
+/* Called from the idle hook.  In real time it parks the idle task's thread in
+sigsuspend() until the next SIGALRM, so it does not spin between ticks; in
+virtual time it returns at once. */
+extern void vPortWaitForTick( void );
+
+/* Tickless idle.  With configUSE_VIRTUAL_TIME the idle task uses it to jump
+the tick count to the next unblock time; in real time the idle task's thread
+sleeps until then with the tick timer stopped, while the other task threads
+stay parked. */
+#if ( configUSE_TICKLESS_IDLE == 1 )
+	extern void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime );
+	#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime )	vPortSuppressTicksAndSleep( xExpectedIdleTime )
+#endif
 
 /* Posix Signal definitions that can be changed or read as appropriate. */
 #define SIG_SUSPEND					SIGUSR1
@@ -0,0 +1,666 @@
+/*
+	POSIX Simulator, single-thread variant
+		Tested with FreeRTOS V10.0.1
+	1 tab == 4 spaces!
+*/
+
+/*-----------------------------------------------------------
+ * Implementation of functions defined in portable.h for the single-thread
+ * Posix port.
+ *
+ * Every task runs on the thread that called vTaskStartScheduler(), each on
+ * its own stack.  A context switch only swaps the callee-saved registers and
+ * the stack pointer, so it does not involve the kernel at all.  The tick is
+ * still a SIGALRM, but its handler only switches away from the idle task:
+ * an application task may be inside non-reentrant C library code (stdio,
+ * malloc) when the signal arrives, so a switch it makes necessary is pended
+ * until that task next calls into the kernel.
+ *----------------------------------------------------------*/
+
+#include <signal.h>
+#include <ucontext.h>
+#include <sys/time.h>
+#include <sys/times.h>
+#include <time.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+/*-----------------------------------------------------------*/
+
+/* Size in bytes of the stack a task runs on while no other size is set with
+vPortSetTaskStackSize().  The stack FreeRTOS allocates for a task is sized in
+words for a microcontroller and is far too small for C library calls and signal
+frames, so it is left unused. */
+#ifndef portTASK_STACK_SIZE
+#define portTASK_STACK_SIZE			( 64 * 1024 )
+#endif
+
+/* The hand-written switch is used where available, ucontext elsewhere. */
+#if defined( __x86_64__ ) || defined( __i386__ )
+#define portASM_CONTEXT_SWITCH		1
+#else
+#define portASM_CONTEXT_SWITCH		0
+#endif
+/*-----------------------------------------------------------*/
+
+/* The execution context of a task.  pxPortInitialiseStack() returns a pointer
+to it in place of a stack pointer, so as the first member of the TCB it is
+reached from a task handle in constant time. */
+typedef struct TASK_CONTEXT
+{
+	void *pvStackPointer;
+#if ( portASM_CONTEXT_SWITCH == 0 )
+	ucontext_t xContext;
+#endif
+	pdTASK_CODE pxCode;
+	void *pvParams;
+	unsigned portBASE_TYPE uxCriticalNesting;
+	portBASE_TYPE xAllocated;
+} xTaskContext;
+/*-----------------------------------------------------------*/
+
+static xTaskContext xMainContext;
+static xTaskContext * volatile pxCurrentContext = NULL;
+/*-----------------------------------------------------------*/
+
+static volatile portBASE_TYPE xInterruptsEnabled = pdTRUE;
+static volatile portBASE_TYPE xServicingTick = pdFALSE;
+static volatile portBASE_TYPE xPendYield = pdFALSE;
+#if ( configUSE_VIRTUAL_TIME == 0 )
+static volatile portBASE_TYPE xTicksSuppressed = pdFALSE;
+#endif
+static volatile unsigned portBASE_TYPE uxCriticalNesting;
+static size_t xTaskStackSize = portTASK_STACK_SIZE;
+static void *pvTaskStack = NULL;
+/*-----------------------------------------------------------*/
+
+/*
+ * Setup the timer to generate the tick interrupts.
+ */
+static void prvSetupTimerInterrupt( void );
+static void prvStopTimerInterrupt( void );
+static void prvSetupSignals( void );
+static xTaskContext *prvGetContext( xTaskHandle hTask );
+static void prvSwitchContext( xTaskContext *pxFrom, xTaskContext *pxTo );
+static void prvSwitchToCurrentTask( void );
+static void prvRestoreInterrupts( void );
+static void prvTaskEntry( void );
+static portBASE_TYPE prvTickShouldAdvance( void );
+#if ( configUSE_TICKLESS_IDLE == 1 ) && ( configUSE_VIRTUAL_TIME == 0 )
+static TickType_t prvSleepWithoutTicks( TickType_t xExpectedIdleTime );
+#endif
+/*-----------------------------------------------------------*/
+
+/*
+ * Exception handlers.
+ */
+void vPortYield( void );
+void vPortSystemTickHandler( int sig, siginfo_t *pxInfo, void *pvContext );
+/*-----------------------------------------------------------*/
+
+#if ( portASM_CONTEXT_SWITCH == 1 )
+
+/*
+ * Save the callee-saved registers on the current stack, store the stack
+ * pointer in *ppvSaveSP, load pvNewSP and restore the registers saved there.
+ */
+void prvSwitchStack( void **ppvSaveSP, void *pvNewSP );
+
+#if defined( __x86_64__ )
+
+/* Registers pushed below the return address, plus one slot holding MXCSR and
+the x87 control word. */
+#define portSAVED_REGISTERS			7
+
+__asm__(
+	"	.text\n"
+	"	.type prvSwitchStack, @function\n"
+	"prvSwitchStack:\n"
+	"	pushq %rbp\n"
+	"	pushq %rbx\n"
+	"	pushq %r12\n"
+	"	pushq %r13\n"
+	"	pushq %r14\n"
+	"	pushq %r15\n"
+	"	subq $8, %rsp\n"
+	"	stmxcsr (%rsp)\n"
+	"	fnstcw 4(%rsp)\n"
+	"	movq %rsp, (%rdi)\n"
+	"	movq %rsi, %rsp\n"
+	"	ldmxcsr (%rsp)\n"
+	"	fldcw 4(%rsp)\n"
+	"	addq $8, %rsp\n"
+	"	popq %r15\n"
+	"	popq %r14\n"
+	"	popq %r13\n"
+	"	popq %r12\n"
+	"	popq %rbx\n"
+	"	popq %rbp\n"
+	"	ret\n"
+	"	.size prvSwitchStack, .-prvSwitchStack\n"
+);
+
+#else /* __i386__ */
+
+#define portSAVED_REGISTERS			4
+
+__asm__(
+	"	.text\n"
+	"	.type prvSwitchStack, @function\n"
+	"prvSwitchStack:\n"
+	"	movl 4(%esp), %eax\n"
+	"	movl 8(%esp), %edx\n"
+	"	pushl %ebp\n"
+	"	pushl %ebx\n"
+	"	pushl %esi\n"
+	"	pushl %edi\n"
+	"	movl %esp, (%eax)\n"
+	"	movl %edx, %esp\n"
+	"	popl %edi\n"
+	"	popl %esi\n"
+	"	popl %ebx\n"
+	"	popl %ebp\n"
+	"	ret\n"
+	"	.size prvSwitchStack, .-prvSwitchStack\n"
+);
+
+#endif /* __x86_64__ */
+
+#endif /* portASM_CONTEXT_SWITCH */
+/*-----------------------------------------------------------*/
+
+/*
+ * See header file for description.
+ */
+portSTACK_TYPE *pxPortInitialiseStack( portSTACK_TYPE *pxTopOfStack, pdTASK_CODE pxCode, void *pvParameters )
+{
+/* The context and the stack the task really runs on share one allocation, or
+the memory set with vPortSetTaskStack(), which then holds the context too. */
+xTaskContext *pxContext;
+size_t xStackSize = xTaskStackSize;
+unsigned char *pucStack;
+
+	( void )pxTopOfStack;
+	if ( NULL == pvTaskStack )
+	{
+		pxContext = pvPortMalloc( sizeof( xTaskContext ) + xStackSize );
+		configASSERT( pxContext );
+		pxContext->xAllocated = pdTRUE;
+	}
+	else
+	{
+		pxContext = ( xTaskContext * )pvTaskStack;
+		pxContext->xAllocated = pdFALSE;
+		xStackSize -= sizeof( xTaskContext );
+	}
+
+	pxContext->pxCode = pxCode;
+	pxContext->pvParams = pvParameters;
+	pxContext->uxCriticalNesting = 0;
+	pucStack = ( unsigned char * )( pxContext + 1 );
+
+#if ( portASM_CONTEXT_SWITCH == 1 )
+	{
+	void **ppvFrame = ( void ** )( ( ( size_t )( pucStack + xStackSize ) ) & ~( ( size_t )15 ) );
+
+		/* Build the frame prvSwitchStack() expects: the task starts in
+		prvTaskEntry() as if it had been called, with a null return address
+		and the stack aligned as the ABI requires at a function entry. */
+		*( --ppvFrame ) = NULL;
+		*( --ppvFrame ) = ( void * )prvTaskEntry;
+		ppvFrame -= portSAVED_REGISTERS;
+		memset( ppvFrame, 0, portSAVED_REGISTERS * sizeof( void * ) );
+	#if defined( __x86_64__ )
+		/* Default MXCSR and x87 control word. */
+		( ( unsigned int * )ppvFrame )[ 0 ] = 0x1F80;
+		( ( unsigned short * )ppvFrame )[ 2 ] = 0x037F;
+	#endif
+		pxContext->pvStackPointer = ppvFrame;
+	}
+#else
+	getcontext( &( pxContext->xContext ) );
+	pxContext->xContext.uc_stack.ss_sp = pucStack;
+	pxContext->xContext.uc_stack.ss_size = xStackSize;
+	pxContext->xContext.uc_link = NULL;
+	makecontext( &( pxContext->xContext ), prvTaskEntry, 0 );
+#endif
+
+	return ( portSTACK_TYPE * )pxContext;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * See header file for description.
+ */
+portBASE_TYPE xPortStartScheduler( void )
+{
+	prvSetupSignals();
+
+	/* Start the timer that generates the tick ISR.  Interrupts are disabled
+	here already. */
+	prvSetupTimerInterrupt();
+
+	/* Start the first task.  vPortEndScheduler() switches back here. */
+	uxCriticalNesting = 0;
+	pxCurrentContext = prvGetContext( xTaskGetCurrentTaskHandle() );
+	prvSwitchContext( &xMainContext, pxCurrentContext );
+
+	prvStopTimerInterrupt();
+	printf( "Cleaning Up, Exiting.\n" );
+
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEndScheduler( void )
+{
+xTaskContext *pxFrom = pxCurrentContext;
+
+	pxCurrentContext = &xMainContext;
+	prvSwitchContext( pxFrom, &xMainContext );
+}
+/*-----------------------------------------------------------*/
+
+void vPortCleanUpTCB( void *pxTCB )
+{
+xTaskContext *pxContext = prvGetContext( ( xTaskHandle )pxTCB );
+
+	/* The task is not running: either another task deleted it, or it
+	deleted itself and the idle task is now freeing its memory.  A stack
+	set with vPortSetTaskStack() belongs to whoever created the task. */
+	if ( pdFALSE != pxContext->xAllocated )
+	{
+		vPortFree( pxContext );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortSetTaskStackSize( size_t xStackSize )
+{
+	xTaskStackSize = ( 0 == xStackSize ) ? portTASK_STACK_SIZE : xStackSize;
+}
+/*-----------------------------------------------------------*/
+
+void vPortSetTaskStack( void *pvStack )
+{
+	pvTaskStack = pvStack;
+}
+/*-----------------------------------------------------------*/
+
+void vPortReserveTaskThreads( unsigned portBASE_TYPE uxThreads )
+{
+	( void )uxThreads;
+}
+/*-----------------------------------------------------------*/
+
+void vPortYieldFromISR( void )
+{
+	/* The tick handler makes the switch itself when it is safe to. */
+	xPendYield = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnterCritical( void )
+{
+	vPortDisableInterrupts();
+	uxCriticalNesting++;
+}
+/*-----------------------------------------------------------*/
+
+void vPortExitCritical( void )
+{
+	/* Check for unmatched exits. */
+	if ( uxCriticalNesting > 0 )
+	{
+		uxCriticalNesting--;
+	}
+
+	/* If we have reached 0 then re-enable the interrupts. */
+	if( uxCriticalNesting == 0 )
+	{
+		/* Has the tick made a switch necessary meanwhile? */
+		if ( pdTRUE == xPendYield )
+		{
+			xPendYield = pdFALSE;
+			vPortYield();
+		}
+		vPortEnableInterrupts();
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortYield( void )
+{
+	vPortDisableInterrupts();
+	xPendYield = pdFALSE;
+	prvSwitchToCurrentTask();
+	prvRestoreInterrupts();
+}
+/*-----------------------------------------------------------*/
+
+void vPortDisableInterrupts( void )
+{
+	xInterruptsEnabled = pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnableInterrupts( void )
+{
+	xInterruptsEnabled = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+portBASE_TYPE xPortSetInterruptMask( void )
+{
+portBASE_TYPE xReturn = xInterruptsEnabled;
+	xInterruptsEnabled = pdFALSE;
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortClearInterruptMask( portBASE_TYPE xMask )
+{
+	xInterruptsEnabled = xMask;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Setup the systick timer to generate the tick interrupts at the required
+ * frequency.
+ */
+void prvSetupTimerInterrupt( void )
+{
+struct itimerval itimer;
+portTickType xMicroSeconds = portTICK_PERIOD_MS * 1000;
+
+	itimer.it_interval.tv_sec = 0;
+	itimer.it_interval.tv_usec = xMicroSeconds;
+	itimer.it_value.tv_sec = 0;
+	itimer.it_value.tv_usec = xMicroSeconds;
+
+	if ( 0 != setitimer( TIMER_TYPE, &itimer, NULL ) )
+	{
+		printf( "Set Timer problem.\n" );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void prvStopTimerInterrupt( void )
+{
+struct itimerval itimer = { { 0, 0 }, { 0, 0 } };
+
+	( void )setitimer( TIMER_TYPE, &itimer, NULL );
+}
+/*-----------------------------------------------------------*/
+
+void vPortSystemTickHandler( int sig, siginfo_t *pxInfo, void *pvContext )
+{
+	( void )sig;
+	( void )pxInfo;
+
+	if ( ( pdTRUE == xInterruptsEnabled ) && ( pdTRUE != xServicingTick ) )
+	{
+		xServicingTick = pdTRUE;
+
+		/* Tick Increment. */
+		if ( pdTRUE == prvTickShouldAdvance() )
+		{
+			if ( pdFALSE != xTaskIncrementTick() )
+			{
+				xPendYield = pdTRUE;
+			}
+		}
+
+#if ( configUSE_PREEMPTION == 1 )
+		if ( ( pdTRUE == xPendYield ) && ( xTaskGetCurrentTaskHandle() == xTaskGetIdleTaskHandle() ) )
+		{
+			xPendYield = pdFALSE;
+			vPortDisableInterrupts();
+			xServicingTick = pdFALSE;
+
+			/* The task switched to does not return through this handler, so
+			give it the signal mask that was in place before the signal. */
+			( void )sigprocmask( SIG_SETMASK, &( ( ( ucontext_t * )pvContext )->uc_sigmask ), NULL );
+
+			prvSwitchToCurrentTask();
+			prvRestoreInterrupts();
+		}
+#endif
+
+		xServicingTick = pdFALSE;
+	}
+	else
+	{
+		/* The tick is lost.  In real time it still asks for the switch it may
+		have made necessary; in virtual time it asks for nothing, otherwise a
+		task would be rotated out at a point that depends on the wall clock and
+		runs would not be reproducible. */
+#if ( configUSE_VIRTUAL_TIME == 0 )
+		xPendYield = pdTRUE;
+#endif
+	}
+}
+/*-----------------------------------------------------------*/
+
+portBASE_TYPE prvTickShouldAdvance( void )
+{
+#if ( configUSE_VIRTUAL_TIME == 1 )
+	/* The handler runs on whichever task the single thread was executing:
+	only one that interrupts the idle task outside its jump counts. */
+	return ( ( xTaskGetCurrentTaskHandle() == xTaskGetIdleTaskHandle() ) &&
+			 ( taskSCHEDULER_SUSPENDED != xTaskGetSchedulerState() ) ) ? pdTRUE : pdFALSE;
+#else
+	return ( pdFALSE == xTicksSuppressed ) ? pdTRUE : pdFALSE;
+#endif
+}
+/*-----------------------------------------------------------*/
+
+void vPortWaitForTick( void )
+{
+#if ( configUSE_VIRTUAL_TIME == 0 )
+sigset_t xTick, xPrevious, xWait;
+
+	/* Here the mask is the whole scheduler's.  The tick handler switches
+	straight from the idle task to any task it readies, so sigsuspend() only
+	returns once the idle task runs again; a switch pended while the handler
+	could not make it is left for the idle task to take instead of waiting. */
+	sigemptyset( &xTick );
+	sigaddset( &xTick, SIG_TICK );
+	( void )sigprocmask( SIG_BLOCK, &xTick, &xPrevious );
+	if ( pdFALSE == xPendYield )
+	{
+		xWait = xPrevious;
+		sigdelset( &xWait, SIG_TICK );
+		( void )sigsuspend( &xWait );
+	}
+	( void )sigprocmask( SIG_SETMASK, &xPrevious, NULL );
+#endif
+}
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TICKLESS_IDLE == 1 )
+
+void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
+{
+	if ( eStandardSleep == eTaskConfirmSleepModeStatus() )
+	{
+#if ( configUSE_VIRTUAL_TIME == 1 )
+		vTaskStepTick( xExpectedIdleTime - 1 );
+		( void )xTaskIncrementTick();
+#else
+		vTaskStepTick( prvSleepWithoutTicks( xExpectedIdleTime ) );
+#endif
+	}
+}
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_VIRTUAL_TIME == 0 )
+
+TickType_t prvSleepWithoutTicks( TickType_t xExpectedIdleTime )
+{
+const long long llTickPeriod = portTICK_PERIOD_MS * 1000000LL;
+struct itimerval xTimer, xStopped = { { 0, 0 }, { 0, 0 } };
+struct timespec xStart, xNow, xDelay;
+long long llFirstTick, llWakeTime, llElapsed, llNextTick;
+TickType_t xTicks;
+
+	/* The whole process sleeps: every task runs on this thread and is
+	blocked, so nanosleep() being cut short by a signal only goes round the
+	loop again. */
+	xTicksSuppressed = pdTRUE;
+	( void )setitimer( TIMER_TYPE, &xStopped, &xTimer );
+	( void )clock_gettime( CLOCK_MONOTONIC, &xStart );
+	llFirstTick = xTimer.it_value.tv_sec * 1000000000LL + xTimer.it_value.tv_usec * 1000LL;
+	if ( 0 == llFirstTick )
+	{
+		llFirstTick = llTickPeriod;
+	}
+
+	llWakeTime = llFirstTick + ( long long )( xExpectedIdleTime - 2 ) * llTickPeriod;
+	for ( ;; )
+	{
+		( void )clock_gettime( CLOCK_MONOTONIC, &xNow );
+		llElapsed = ( xNow.tv_sec - xStart.tv_sec ) * 1000000000LL + ( xNow.tv_nsec - xStart.tv_nsec );
+		if ( llElapsed >= llWakeTime )
+		{
+			break;
+		}
+		xDelay.tv_sec = ( time_t )( ( llWakeTime - llElapsed ) / 1000000000LL );
+		xDelay.tv_nsec = ( long )( ( llWakeTime - llElapsed ) % 1000000000LL );
+		( void )nanosleep( &xDelay, NULL );
+	}
+
+	xTicks = ( TickType_t )( 1 + ( llElapsed - llFirstTick ) / llTickPeriod );
+	if ( xTicks > xExpectedIdleTime - 1 )
+	{
+		xTicks = xExpectedIdleTime - 1;
+	}
+	llNextTick = llFirstTick + ( long long )xTicks * llTickPeriod - llElapsed;
+	if ( llNextTick < 1000LL )
+	{
+		llNextTick = 1000LL;
+	}
+
+	xTimer.it_interval.tv_sec = 0;
+	xTimer.it_interval.tv_usec = ( suseconds_t )( llTickPeriod / 1000LL );
+	xTimer.it_value.tv_sec = ( time_t )( llNextTick / 1000000000LL );
+	xTimer.it_value.tv_usec = ( suseconds_t )( ( llNextTick % 1000000000LL ) / 1000LL );
+	xTicksSuppressed = pdFALSE;
+	if ( 0 != setitimer( TIMER_TYPE, &xTimer, NULL ) )
+	{
+		printf( "Set Timer problem.\n" );
+	}
+
+	return xTicks;
+}
+
+#endif /* configUSE_VIRTUAL_TIME */
+
+#endif /* configUSE_TICKLESS_IDLE */
+/*-----------------------------------------------------------*/
+
+void prvSetupSignals( void )
+{
+struct sigaction sigtick;
+
+	sigtick.sa_flags = SA_SIGINFO | SA_RESTART;
+	sigtick.sa_sigaction = vPortSystemTickHandler;
+	sigfillset( &sigtick.sa_mask );
+
+	if ( 0 != sigaction( SIG_TICK, &sigtick, NULL ) )
+	{
+		printf( "Problem installing SIG_TICK\n" );
+	}
+	printf( "Running as PID: %d\n", getpid() );
+}
+/*-----------------------------------------------------------*/
+
+xTaskContext *prvGetContext( xTaskHandle hTask )
+{
+	/* pxTopOfStack, the first member of the TCB, holds the context. */
+	return *( xTaskContext ** )hTask;
+}
+/*-----------------------------------------------------------*/
+
+void prvSwitchContext( xTaskContext *pxFrom, xTaskContext *pxTo )
+{
+#if ( portASM_CONTEXT_SWITCH == 1 )
+	prvSwitchStack( &( pxFrom->pvStackPointer ), pxTo->pvStackPointer );
+#else
+	( void )swapcontext( &( pxFrom->xContext ), &( pxTo->xContext ) );
+#endif
+}
+/*-----------------------------------------------------------*/
+
+void prvSwitchToCurrentTask( void )
+{
+xTaskContext *pxFrom = pxCurrentContext;
+xTaskContext *pxTo;
+
+	/* Must be called with interrupts disabled. */
+	vTaskSwitchContext();
+	pxTo = prvGetContext( xTaskGetCurrentTaskHandle() );
+
+	if ( pxFrom != pxTo )
+	{
+		/* Remember and switch the critical nesting. */
+		pxFrom->uxCriticalNesting = uxCriticalNesting;
+		pxCurrentContext = pxTo;
+		prvSwitchContext( pxFrom, pxTo );
+
+		/* Resumed by a later switch back to this task. */
+		uxCriticalNesting = pxFrom->uxCriticalNesting;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void prvRestoreInterrupts( void )
+{
+	/* Need to set the interrupts based on the task's critical nesting. */
+	if ( uxCriticalNesting == 0 )
+	{
+		vPortEnableInterrupts();
+	}
+	else
+	{
+		vPortDisableInterrupts();
+	}
+}
+/*-----------------------------------------------------------*/
+
+void prvTaskEntry( void )
+{
+xTaskContext *pxContext = pxCurrentContext;
+
+	/* A task starts with no critical nesting. */
+	uxCriticalNesting = 0;
+	vPortEnableInterrupts();
+
+	pxContext->pxCode( pxContext->pvParams );
+
+	/* Tasks must not return; treat it as the task ending. */
+	vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+void vPortFindTicksPerSecond( void )
+{
+	/* Needs to be reasonably high for accuracy. */
+	unsigned long ulTicksPerSecond = sysconf(_SC_CLK_TCK);
+	printf( "Timer Resolution for Run TimeStats is %ld ticks per second.\n", ulTicksPerSecond );
+}
+/*-----------------------------------------------------------*/
+
+unsigned long ulPortGetTimerValue( void )
+{
+struct tms xTimes;
+	( void )times( &xTimes );
+	/* Return the application code times. */
+	return ( unsigned long ) xTimes.tms_utime;
+}
+/*-----------------------------------------------------------*/
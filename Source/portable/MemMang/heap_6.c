@@ -0,0 +1,410 @@
+/*
+	Constant-time heap for the POSIX simulator
+		Tested with FreeRTOS V10.0.1
+	1 tab == 4 spaces!
+*/
+
+/*
+ * An implementation of pvPortMalloc() and vPortFree() that takes constant
+ * time whatever the number of free blocks, using two-level segregated fits
+ * (TLSF).  Free blocks are kept in one list per size class: each power of two
+ * is split into heapSL_COUNT classes, and a bitmap per level records which
+ * lists are not empty, so the smallest class that certainly fits a request is
+ * found with two find-first-set operations instead of a walk of the free
+ * list.  A freed block is merged with its free neighbours straight away,
+ * through the physical links in the block headers, which keeps fragmentation
+ * low.
+ *
+ * The memory comes from the host in regions of at least configHEAP_REGION_SIZE
+ * bytes, requested with malloc() whenever no free block fits; regions are
+ * never given back.  Only that growth is not constant time.
+ *
+ * See heap_1.c to heap_5.c for alternative implementations, and the memory
+ * management pages of http://www.FreeRTOS.org for more information.
+ */
+#include <stdlib.h>
+#include <stddef.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
+	#error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
+#endif
+
+/* Bytes requested from the host each time the heap runs out.  A larger
+request gets a region of its own size. */
+#ifndef configHEAP_REGION_SIZE
+	#define configHEAP_REGION_SIZE		( 1024 * 1024 )
+#endif
+
+#if portBYTE_ALIGNMENT == 32
+	#define heapALIGNMENT_LOG2			( 5 )
+#elif portBYTE_ALIGNMENT == 16
+	#define heapALIGNMENT_LOG2			( 4 )
+#elif portBYTE_ALIGNMENT == 8
+	#define heapALIGNMENT_LOG2			( 3 )
+#elif portBYTE_ALIGNMENT == 4
+	#define heapALIGNMENT_LOG2			( 2 )
+#else
+	#error heap_6.c needs portBYTE_ALIGNMENT to be at least 4, the low bits of a block size hold its flags
+#endif
+
+/* Assumes 8bit bytes! */
+#define heapBITS_PER_BYTE			( ( size_t ) 8 )
+
+/* Each power of two is split into heapSL_COUNT size classes (the second
+level).  Sizes below heapSMALL_BLOCK_SIZE all belong to the first first-level
+index, in classes one alignment unit apart. */
+#define heapSL_LOG2					( 4 )
+#define heapSL_COUNT				( 1 << heapSL_LOG2 )
+#define heapFL_SHIFT				( heapSL_LOG2 + heapALIGNMENT_LOG2 )
+#define heapSMALL_BLOCK_SIZE		( ( size_t ) 1 << heapFL_SHIFT )
+#define heapFL_COUNT				( ( sizeof( size_t ) * heapBITS_PER_BYTE ) - heapFL_SHIFT + 1 )
+
+/* Flags kept in the low bits of the size of a block. */
+#define heapBLOCK_FREE				( ( size_t ) 1 )
+#define heapPREV_FREE				( ( size_t ) 2 )
+#define heapFLAGS					( heapBLOCK_FREE | heapPREV_FREE )
+
+/* Requests are limited so that rounding them up cannot overflow. */
+#define heapMAXIMUM_SIZE			( ( ( size_t ) -1 ) >> 2 )
+
+/* The header of every block.  The free list links are only valid while the
+block is free and occupy the first bytes of the memory handed to the
+application, so a block in use costs just the physical link and the size. */
+typedef struct HEAP_BLOCK
+{
+	struct HEAP_BLOCK *pxPrevPhysical;	/*<< The block just before this one in memory, NULL for the first block of a region. */
+	size_t xSize;						/*<< Bytes after the header, with heapBLOCK_FREE and heapPREV_FREE in the low bits. */
+	struct HEAP_BLOCK *pxNextFree;		/*<< The next block in the free list of the same class. */
+	struct HEAP_BLOCK *pxPrevFree;		/*<< The previous block in the free list of the same class. */
+} HeapBlock_t;
+
+#define heapHEADER_SIZE				( ( size_t ) offsetof( HeapBlock_t, pxNextFree ) )
+#define heapMINIMUM_SIZE			( ( sizeof( HeapBlock_t ) - heapHEADER_SIZE + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK ) )
+
+#define heapBLOCK_SIZE( pxBlock )		( ( pxBlock )->xSize & ~heapFLAGS )
+#define heapNEXT_PHYSICAL( pxBlock )	( ( HeapBlock_t * ) ( ( ( uint8_t * ) ( pxBlock ) ) + heapHEADER_SIZE + heapBLOCK_SIZE( pxBlock ) ) )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Index of the most significant bit set in xValue, which must not be zero.
+ */
+static UBaseType_t prvFls( size_t xValue );
+
+/*
+ * The first and second level indexes of the class of a block of xSize bytes.
+ */
+static void prvMapping( size_t xSize, UBaseType_t *puxFl, UBaseType_t *puxSl );
+
+/*
+ * Take out of its free list a free block of at least xSearchSize bytes from
+ * the smallest non-empty class whose blocks are all that large, or return
+ * NULL if there is none.
+ */
+static HeapBlock_t *prvTakeFreeBlock( size_t xSearchSize );
+
+static void prvInsertFreeBlock( HeapBlock_t *pxBlock );
+static void prvRemoveFreeBlock( HeapBlock_t *pxBlock );
+
+/*
+ * Get a region from the host holding one free block of at least xSize bytes.
+ */
+static BaseType_t prvAddRegion( size_t xSize );
+
+/*-----------------------------------------------------------*/
+
+/* The heads of the free lists, and the bitmaps of the non-empty ones. */
+static HeapBlock_t *pxFreeLists[ heapFL_COUNT ][ heapSL_COUNT ];
+static size_t uxFlBitmap = 0;
+static uint32_t ulSlBitmap[ heapFL_COUNT ];
+
+/* Bytes in free blocks, headers included, and the fewest there have been
+since the heap last grew. */
+static size_t xFreeBytesRemaining = 0U;
+static size_t xMinimumEverFreeBytesRemaining = 0U;
+
+/*-----------------------------------------------------------*/
+
+void *pvPortMalloc( size_t xWantedSize )
+{
+HeapBlock_t *pxBlock, *pxRemainder;
+size_t xSize, xSearchSize;
+void *pvReturn = NULL;
+
+	if( ( xWantedSize > 0 ) && ( xWantedSize <= heapMAXIMUM_SIZE ) )
+	{
+		/* The block must be able to hold the free list links once it is
+		freed, and keep the next block aligned. */
+		xSize = ( xWantedSize + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+		if( xSize < heapMINIMUM_SIZE )
+		{
+			xSize = heapMINIMUM_SIZE;
+		}
+
+		/* Search from the next class up, all of whose blocks fit. */
+		xSearchSize = xSize;
+		if( xSearchSize >= heapSMALL_BLOCK_SIZE )
+		{
+			xSearchSize += ( ( size_t ) 1 << ( prvFls( xSearchSize ) - heapSL_LOG2 ) ) - 1;
+		}
+
+		vTaskSuspendAll();
+		{
+			pxBlock = prvTakeFreeBlock( xSearchSize );
+			if( ( pxBlock == NULL ) && ( prvAddRegion( xSearchSize ) != pdFALSE ) )
+			{
+				pxBlock = prvTakeFreeBlock( xSearchSize );
+			}
+
+			if( pxBlock != NULL )
+			{
+				xFreeBytesRemaining -= heapHEADER_SIZE + heapBLOCK_SIZE( pxBlock );
+
+				/* Split off the end of the block if it can make a block of its
+				own.  The block after it keeps heapPREV_FREE. */
+				if( ( heapBLOCK_SIZE( pxBlock ) - xSize ) >= ( heapHEADER_SIZE + heapMINIMUM_SIZE ) )
+				{
+					pxRemainder = ( HeapBlock_t * ) ( ( ( uint8_t * ) pxBlock ) + heapHEADER_SIZE + xSize );
+					pxRemainder->pxPrevPhysical = pxBlock;
+					pxRemainder->xSize = ( heapBLOCK_SIZE( pxBlock ) - xSize - heapHEADER_SIZE ) | heapBLOCK_FREE;
+					heapNEXT_PHYSICAL( pxRemainder )->pxPrevPhysical = pxRemainder;
+					pxBlock->xSize = xSize | ( pxBlock->xSize & heapFLAGS );
+					prvInsertFreeBlock( pxRemainder );
+					xFreeBytesRemaining += heapHEADER_SIZE + heapBLOCK_SIZE( pxRemainder );
+				}
+				else
+				{
+					heapNEXT_PHYSICAL( pxBlock )->xSize &= ~heapPREV_FREE;
+				}
+
+				pxBlock->xSize &= ~heapBLOCK_FREE;
+				pvReturn = ( void * ) ( ( ( uint8_t * ) pxBlock ) + heapHEADER_SIZE );
+
+				if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+				{
+					xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+				}
+			}
+
+			traceMALLOC( pvReturn, xWantedSize );
+		}
+		( void ) xTaskResumeAll();
+	}
+
+	#if( configUSE_MALLOC_FAILED_HOOK == 1 )
+	{
+		if( pvReturn == NULL )
+		{
+			extern void vApplicationMallocFailedHook( void );
+			vApplicationMallocFailedHook();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	#endif
+
+	configASSERT( ( ( ( size_t ) pvReturn ) & ( size_t ) portBYTE_ALIGNMENT_MASK ) == 0 );
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void *pv )
+{
+HeapBlock_t *pxBlock, *pxNeighbour;
+
+	if( pv != NULL )
+	{
+		pxBlock = ( HeapBlock_t * ) ( ( ( uint8_t * ) pv ) - heapHEADER_SIZE );
+		configASSERT( ( pxBlock->xSize & heapBLOCK_FREE ) == 0 );
+
+		vTaskSuspendAll();
+		{
+			traceFREE( pv, heapBLOCK_SIZE( pxBlock ) );
+			xFreeBytesRemaining += heapHEADER_SIZE + heapBLOCK_SIZE( pxBlock );
+
+			/* Merge with the free block just before, then with the one just
+			after.  Neither of those can have a free neighbour of its own. */
+			if( ( pxBlock->xSize & heapPREV_FREE ) != 0 )
+			{
+				pxNeighbour = pxBlock->pxPrevPhysical;
+				prvRemoveFreeBlock( pxNeighbour );
+				pxNeighbour->xSize += heapHEADER_SIZE + heapBLOCK_SIZE( pxBlock );
+				pxBlock = pxNeighbour;
+			}
+
+			pxNeighbour = heapNEXT_PHYSICAL( pxBlock );
+			if( ( pxNeighbour->xSize & heapBLOCK_FREE ) != 0 )
+			{
+				prvRemoveFreeBlock( pxNeighbour );
+				pxBlock->xSize += heapHEADER_SIZE + heapBLOCK_SIZE( pxNeighbour );
+				pxNeighbour = heapNEXT_PHYSICAL( pxBlock );
+			}
+
+			pxBlock->xSize |= heapBLOCK_FREE;
+			pxNeighbour->pxPrevPhysical = pxBlock;
+			pxNeighbour->xSize |= heapPREV_FREE;
+			prvInsertFreeBlock( pxBlock );
+		}
+		( void ) xTaskResumeAll();
+	}
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+	return xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+	return xMinimumEverFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+static UBaseType_t prvFls( size_t xValue )
+{
+	return ( UBaseType_t ) ( ( sizeof( unsigned long ) * heapBITS_PER_BYTE - 1 ) - __builtin_clzl( ( unsigned long ) xValue ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvMapping( size_t xSize, UBaseType_t *puxFl, UBaseType_t *puxSl )
+{
+UBaseType_t uxFl;
+
+	if( xSize < heapSMALL_BLOCK_SIZE )
+	{
+		*puxFl = 0;
+		*puxSl = ( UBaseType_t ) ( xSize >> heapALIGNMENT_LOG2 );
+	}
+	else
+	{
+		uxFl = prvFls( xSize );
+		*puxSl = ( UBaseType_t ) ( ( xSize >> ( uxFl - heapSL_LOG2 ) ) ^ heapSL_COUNT );
+		*puxFl = uxFl - heapFL_SHIFT + 1;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static HeapBlock_t *prvTakeFreeBlock( size_t xSearchSize )
+{
+UBaseType_t uxFl, uxSl;
+uint32_t ulSlMap;
+size_t uxFlMap;
+HeapBlock_t *pxBlock;
+
+	prvMapping( xSearchSize, &uxFl, &uxSl );
+
+	/* A larger class of the same power of two, or else the smallest class
+	of the next non-empty power of two. */
+	ulSlMap = ulSlBitmap[ uxFl ] & ( ~( uint32_t ) 0 << uxSl );
+	if( ulSlMap == 0 )
+	{
+		uxFlMap = uxFlBitmap & ( ~( size_t ) 0 << ( uxFl + 1 ) );
+		if( uxFlMap == 0 )
+		{
+			return NULL;
+		}
+		uxFl = ( UBaseType_t ) __builtin_ctzl( ( unsigned long ) uxFlMap );
+		ulSlMap = ulSlBitmap[ uxFl ];
+	}
+	uxSl = ( UBaseType_t ) __builtin_ctz( ulSlMap );
+
+	pxBlock = pxFreeLists[ uxFl ][ uxSl ];
+	prvRemoveFreeBlock( pxBlock );
+	return pxBlock;
+}
+/*-----------------------------------------------------------*/
+
+static void prvInsertFreeBlock( HeapBlock_t *pxBlock )
+{
+UBaseType_t uxFl, uxSl;
+
+	prvMapping( heapBLOCK_SIZE( pxBlock ), &uxFl, &uxSl );
+
+	pxBlock->pxPrevFree = NULL;
+	pxBlock->pxNextFree = pxFreeLists[ uxFl ][ uxSl ];
+	if( pxBlock->pxNextFree != NULL )
+	{
+		pxBlock->pxNextFree->pxPrevFree = pxBlock;
+	}
+	pxFreeLists[ uxFl ][ uxSl ] = pxBlock;
+
+	uxFlBitmap |= ( size_t ) 1 << uxFl;
+	ulSlBitmap[ uxFl ] |= ( uint32_t ) 1 << uxSl;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRemoveFreeBlock( HeapBlock_t *pxBlock )
+{
+UBaseType_t uxFl, uxSl;
+
+	prvMapping( heapBLOCK_SIZE( pxBlock ), &uxFl, &uxSl );
+
+	if( pxBlock->pxNextFree != NULL )
+	{
+		pxBlock->pxNextFree->pxPrevFree = pxBlock->pxPrevFree;
+	}
+	if( pxBlock->pxPrevFree != NULL )
+	{
+		pxBlock->pxPrevFree->pxNextFree = pxBlock->pxNextFree;
+	}
+	else
+	{
+		/* The block was the head of its list. */
+		pxFreeLists[ uxFl ][ uxSl ] = pxBlock->pxNextFree;
+		if( pxBlock->pxNextFree == NULL )
+		{
+			ulSlBitmap[ uxFl ] &= ~( ( uint32_t ) 1 << uxSl );
+			if( ulSlBitmap[ uxFl ] == 0 )
+			{
+				uxFlBitmap &= ~( ( size_t ) 1 << uxFl );
+			}
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvAddRegion( size_t xSize )
+{
+size_t xRegionSize = xSize + ( 2 * heapHEADER_SIZE ) + portBYTE_ALIGNMENT_MASK;
+HeapBlock_t *pxBlock, *pxEnd;
+
+	if( xRegionSize < configHEAP_REGION_SIZE )
+	{
+		xRegionSize = configHEAP_REGION_SIZE;
+	}
+
+	/* malloc() aligns for any type, so for portBYTE_ALIGNMENT as well. */
+	pxBlock = ( HeapBlock_t * ) malloc( xRegionSize );
+	if( pxBlock == NULL )
+	{
+		return pdFALSE;
+	}
+
+	/* One free block, then a block in use of no size that stops merging at
+	the end of the region. */
+	pxBlock->pxPrevPhysical = NULL;
+	pxBlock->xSize = ( ( xRegionSize - ( 2 * heapHEADER_SIZE ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK ) ) | heapBLOCK_FREE;
+	pxEnd = heapNEXT_PHYSICAL( pxBlock );
+	pxEnd->pxPrevPhysical = pxBlock;
+	pxEnd->xSize = heapPREV_FREE;
+
+	prvInsertFreeBlock( pxBlock );
+	xFreeBytesRemaining += heapHEADER_SIZE + heapBLOCK_SIZE( pxBlock );
+	xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+
+	return pdTRUE;
+}
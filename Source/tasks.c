@@ -349,10 +349,46 @@ PRIVILEGED_DATA TCB_t * volatile pxCurrentTCB = NULL;
 
 /* Lists for ready and blocked tasks. --------------------*/
 PRIVILEGED_DATA static List_t pxReadyTasksLists[ configMAX_PRIORITIES ];/*< Prioritised ready tasks. */
-PRIVILEGED_DATA static List_t xDelayedTaskList1;						/*< Delayed tasks. */
-PRIVILEGED_DATA static List_t xDelayedTaskList2;						/*< Delayed tasks (two lists are used - one for delays that have overflowed the current tick count. */
-PRIVILEGED_DATA static List_t * volatile pxDelayedTaskList;				/*< Points to the delayed task list currently being used. */
-PRIVILEGED_DATA static List_t * volatile pxOverflowDelayedTaskList;		/*< Points to the delayed task list currently being used to hold tasks that have overflowed the current tick count. */
+
+#if ( configUSE_DELAYED_TASK_WHEEL == 1 )
+
+	/* Hierarchical timing wheel holding the delayed tasks in place of the two
+	sorted delayed lists, so blocking is O(1) instead of a walk of every other
+	delayed task.  Level 0 has one unsorted list per tick; each level above
+	covers taskWHEEL_SLOTS slots of the one below.  A task is filed on the
+	lowest level whose parent slot holds both its wake time and
+	xDelayedTaskWheelTime, and a slot is moved down a level when the wheel time
+	enters it.  The tasks found in the level 0 slot of a tick are therefore
+	exactly those that wake on that tick. */
+	#define taskWHEEL_BITS		( 6U )
+	#define taskWHEEL_SLOTS		( 1U << taskWHEEL_BITS )
+	#define taskWHEEL_MASK		( taskWHEEL_SLOTS - 1U )
+	#define taskWHEEL_LEVELS	( ( ( sizeof( TickType_t ) * 8U ) + taskWHEEL_BITS - 1U ) / taskWHEEL_BITS )
+
+	/* Wake times further ahead than this could alias with a slot that has
+	already been passed in the current lap of the tick count. */
+	#define taskWHEEL_MAX_DELAY	( portMAX_DELAY - ( portMAX_DELAY >> 2 ) )
+
+	#define taskIS_DELAYED_LIST( pxList ) ( ( ( pxList ) >= &( xDelayedTaskWheel[ 0 ][ 0 ] ) ) && ( ( pxList ) <= &( xDelayedTaskWheel[ taskWHEEL_LEVELS - 1U ][ taskWHEEL_MASK ] ) ) )
+
+	/* The wheel holds overflowed wake times too, so the list is ignored. */
+	#define taskINSERT_DELAYED_TASK( pxList, pxListItem ) prvInsertDelayedTask( pxListItem )
+
+	PRIVILEGED_DATA static List_t xDelayedTaskWheel[ taskWHEEL_LEVELS ][ taskWHEEL_SLOTS ];	/*< Delayed tasks, filed by wake time. */
+	PRIVILEGED_DATA static TickType_t xDelayedTaskWheelTime;								/*< The tick count the wheel has been advanced to. */
+
+#else
+
+	PRIVILEGED_DATA static List_t xDelayedTaskList1;						/*< Delayed tasks. */
+	PRIVILEGED_DATA static List_t xDelayedTaskList2;						/*< Delayed tasks (two lists are used - one for delays that have overflowed the current tick count. */
+	PRIVILEGED_DATA static List_t * volatile pxDelayedTaskList;				/*< Points to the delayed task list currently being used. */
+	PRIVILEGED_DATA static List_t * volatile pxOverflowDelayedTaskList;		/*< Points to the delayed task list currently being used to hold tasks that have overflowed the current tick count. */
+
+	#define taskIS_DELAYED_LIST( pxList ) ( ( ( pxList ) == pxDelayedTaskList ) || ( ( pxList ) == pxOverflowDelayedTaskList ) )
+	#define taskINSERT_DELAYED_TASK( pxList, pxListItem ) vListInsert( ( pxList ), ( pxListItem ) )
+
+#endif /* configUSE_DELAYED_TASK_WHEEL */
+
 PRIVILEGED_DATA static List_t xPendingReadyList;						/*< Tasks that have been readied while the scheduler was suspended.  They will be moved to the ready list when the scheduler is resumed. */
 
 #if( INCLUDE_vTaskDelete == 1 )
@@ -534,6 +570,22 @@ static void prvAddCurrentTaskToDelayedList( TickType_t xTicksToWait, const BaseT
  */
 static void prvResetNextTaskUnblockTime( void );
 
+#if ( configUSE_DELAYED_TASK_WHEEL == 1 )
+
+	/*
+	 * File a delayed task's state list item, whose value is its wake time, in
+	 * the delayed task wheel.
+	 */
+	static void prvInsertDelayedTask( ListItem_t * const pxStateListItem ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Move the delayed task wheel to xNewTime, which must not pass the wake
+	 * time of any delayed task, moving down the slots it enters.
+	 */
+	static void prvAdvanceDelayedTaskWheel( const TickType_t xNewTime ) PRIVILEGED_FUNCTION;
+
+#endif
+
 #if ( ( configUSE_TRACE_FACILITY == 1 ) && ( configUSE_STATS_FORMATTING_FUNCTIONS > 0 ) )
 
 	/*
@@ -1351,7 +1403,7 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
 			}
 			taskEXIT_CRITICAL();
 
-			if( ( pxStateList == pxDelayedTaskList ) || ( pxStateList == pxOverflowDelayedTaskList ) )
+			if( taskIS_DELAYED_LIST( pxStateList ) )
 			{
 				/* The task being queried is referenced from one of the Blocked
 				lists. */
@@ -1984,6 +2036,12 @@ BaseType_t xReturn;
 		xSchedulerRunning = pdTRUE;
 		xTickCount = ( TickType_t ) 0U;
 
+		#if ( configUSE_DELAYED_TASK_WHEEL == 1 )
+		{
+			xDelayedTaskWheelTime = xTickCount;
+		}
+		#endif
+
 		/* If configGENERATE_RUN_TIME_STATS is defined then the following
 		macro must be defined to configure the timer/counter used to generate
 		the run time counter time base.   NOTE:  If configGENERATE_RUN_TIME_STATS
@@ -2366,15 +2424,28 @@ TCB_t *pxTCB;
 			} while( uxQueue > ( UBaseType_t ) tskIDLE_PRIORITY ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
 
 			/* Search the delayed lists. */
-			if( pxTCB == NULL )
+			#if ( configUSE_DELAYED_TASK_WHEEL == 1 )
 			{
-				pxTCB = prvSearchForNameWithinSingleList( ( List_t * ) pxDelayedTaskList, pcNameToQuery );
-			}
+			UBaseType_t uxSlot;
 
-			if( pxTCB == NULL )
+				for( uxSlot = 0; ( uxSlot < ( taskWHEEL_LEVELS * taskWHEEL_SLOTS ) ) && ( pxTCB == NULL ); uxSlot++ )
+				{
+					pxTCB = prvSearchForNameWithinSingleList( &( xDelayedTaskWheel[ uxSlot / taskWHEEL_SLOTS ][ uxSlot % taskWHEEL_SLOTS ] ), pcNameToQuery );
+				}
+			}
+			#else
 			{
-				pxTCB = prvSearchForNameWithinSingleList( ( List_t * ) pxOverflowDelayedTaskList, pcNameToQuery );
+				if( pxTCB == NULL )
+				{
+					pxTCB = prvSearchForNameWithinSingleList( ( List_t * ) pxDelayedTaskList, pcNameToQuery );
+				}
+
+				if( pxTCB == NULL )
+				{
+					pxTCB = prvSearchForNameWithinSingleList( ( List_t * ) pxOverflowDelayedTaskList, pcNameToQuery );
+				}
 			}
+			#endif
 
 			#if ( INCLUDE_vTaskSuspend == 1 )
 			{
@@ -2426,8 +2497,21 @@ TCB_t *pxTCB;
 
 				/* Fill in an TaskStatus_t structure with information on each
 				task in the Blocked state. */
-				uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), ( List_t * ) pxDelayedTaskList, eBlocked );
-				uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), ( List_t * ) pxOverflowDelayedTaskList, eBlocked );
+				#if ( configUSE_DELAYED_TASK_WHEEL == 1 )
+				{
+				UBaseType_t uxSlot;
+
+					for( uxSlot = 0; uxSlot < ( taskWHEEL_LEVELS * taskWHEEL_SLOTS ); uxSlot++ )
+					{
+						uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), &( xDelayedTaskWheel[ uxSlot / taskWHEEL_SLOTS ][ uxSlot % taskWHEEL_SLOTS ] ), eBlocked );
+					}
+				}
+				#else
+				{
+					uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), ( List_t * ) pxDelayedTaskList, eBlocked );
+					uxTask += prvListTasksWithinSingleList( &( pxTaskStatusArray[ uxTask ] ), ( List_t * ) pxOverflowDelayedTaskList, eBlocked );
+				}
+				#endif
 
 				#if( INCLUDE_vTaskDelete == 1 )
 				{
@@ -2504,6 +2588,15 @@ implementations require configUSE_TICKLESS_IDLE to be set to a value other than
 		each stepped tick. */
 		configASSERT( ( xTickCount + xTicksToJump ) <= xNextTaskUnblockTime );
 		xTickCount += xTicksToJump;
+
+		#if ( configUSE_DELAYED_TASK_WHEEL == 1 )
+		{
+			/* No task wakes in the ticks jumped over, so only the slots the
+			wheel lands in need moving down. */
+			prvAdvanceDelayedTaskWheel( xTickCount );
+		}
+		#endif
+
 		traceINCREASE_TICK_COUNT( xTicksToJump );
 	}
 
@@ -2606,31 +2699,68 @@ BaseType_t xSwitchRequired = pdFALSE;
 		delayed lists if it wraps to 0. */
 		xTickCount = xConstTickCount;
 
-		if( xConstTickCount == ( TickType_t ) 0U ) /*lint !e774 'if' does not always evaluate to false as it is looking for an overflow. */
+		#if ( configUSE_DELAYED_TASK_WHEEL == 1 )
 		{
-			taskSWITCH_DELAYED_LISTS();
+			prvAdvanceDelayedTaskWheel( xConstTickCount );
+
+			if( xConstTickCount == ( TickType_t ) 0U ) /*lint !e774 'if' does not always evaluate to false as it is looking for an overflow. */
+			{
+				/* The tasks that wake after the overflow are now the next to
+				unblock. */
+				xNumOfOverflows++;
+				prvResetNextTaskUnblockTime();
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
 		}
-		else
+		#else
 		{
-			mtCOVERAGE_TEST_MARKER();
+			if( xConstTickCount == ( TickType_t ) 0U ) /*lint !e774 'if' does not always evaluate to false as it is looking for an overflow. */
+			{
+				taskSWITCH_DELAYED_LISTS();
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
 		}
+		#endif /* configUSE_DELAYED_TASK_WHEEL */
 
 		/* See if this tick has made a timeout expire.  Tasks are stored in
 		the	queue in the order of their wake time - meaning once one task
 		has been found whose block time has not expired there is no need to
-		look any further down the list. */
+		look any further down the list.  With the delayed task wheel the
+		tasks to unblock are all those in the level 0 slot of this tick. */
 		if( xConstTickCount >= xNextTaskUnblockTime )
 		{
+			#if ( configUSE_DELAYED_TASK_WHEEL == 1 )
+				List_t * const pxDueList = &( xDelayedTaskWheel[ 0 ][ xConstTickCount & taskWHEEL_MASK ] );
+			#else
+				List_t * const pxDueList = pxDelayedTaskList;
+			#endif
+
 			for( ;; )
 			{
-				if( listLIST_IS_EMPTY( pxDelayedTaskList ) != pdFALSE )
+				if( listLIST_IS_EMPTY( pxDueList ) != pdFALSE )
 				{
-					/* The delayed list is empty.  Set xNextTaskUnblockTime
-					to the maximum possible value so it is extremely
-					unlikely that the
-					if( xTickCount >= xNextTaskUnblockTime ) test will pass
-					next time through. */
-					xNextTaskUnblockTime = portMAX_DELAY; /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+					#if ( configUSE_DELAYED_TASK_WHEEL == 1 )
+					{
+						/* Find the wake time of the next task in the
+						wheel. */
+						prvResetNextTaskUnblockTime();
+					}
+					#else
+					{
+						/* The delayed list is empty.  Set xNextTaskUnblockTime
+						to the maximum possible value so it is extremely
+						unlikely that the
+						if( xTickCount >= xNextTaskUnblockTime ) test will pass
+						next time through. */
+						xNextTaskUnblockTime = portMAX_DELAY; /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+					}
+					#endif
 					break;
 				}
 				else
@@ -2639,7 +2769,7 @@ BaseType_t xSwitchRequired = pdFALSE;
 					item at the head of the delayed list.  This is the time
 					at which the task at the head of the delayed list must
 					be removed from the Blocked state. */
-					pxTCB = ( TCB_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxDelayedTaskList );
+					pxTCB = ( TCB_t * ) listGET_OWNER_OF_HEAD_ENTRY( pxDueList );
 					xItemValue = listGET_LIST_ITEM_VALUE( &( pxTCB->xStateListItem ) );
 
 					if( xConstTickCount < xItemValue )
@@ -3442,8 +3572,26 @@ UBaseType_t uxPriority;
 		vListInitialise( &( pxReadyTasksLists[ uxPriority ] ) );
 	}
 
-	vListInitialise( &xDelayedTaskList1 );
-	vListInitialise( &xDelayedTaskList2 );
+	#if ( configUSE_DELAYED_TASK_WHEEL == 1 )
+	{
+	UBaseType_t uxLevel, uxSlot;
+
+		for( uxLevel = ( UBaseType_t ) 0U; uxLevel < ( UBaseType_t ) taskWHEEL_LEVELS; uxLevel++ )
+		{
+			for( uxSlot = ( UBaseType_t ) 0U; uxSlot < ( UBaseType_t ) taskWHEEL_SLOTS; uxSlot++ )
+			{
+				vListInitialise( &( xDelayedTaskWheel[ uxLevel ][ uxSlot ] ) );
+			}
+		}
+		xDelayedTaskWheelTime = xTickCount;
+	}
+	#else
+	{
+		vListInitialise( &xDelayedTaskList1 );
+		vListInitialise( &xDelayedTaskList2 );
+	}
+	#endif /* configUSE_DELAYED_TASK_WHEEL */
+
 	vListInitialise( &xPendingReadyList );
 
 	#if ( INCLUDE_vTaskDelete == 1 )
@@ -3458,10 +3606,14 @@ UBaseType_t uxPriority;
 	}
 	#endif /* INCLUDE_vTaskSuspend */
 
-	/* Start with pxDelayedTaskList using list1 and the pxOverflowDelayedTaskList
-	using list2. */
-	pxDelayedTaskList = &xDelayedTaskList1;
-	pxOverflowDelayedTaskList = &xDelayedTaskList2;
+	#if ( configUSE_DELAYED_TASK_WHEEL == 0 )
+	{
+		/* Start with pxDelayedTaskList using list1 and the
+		pxOverflowDelayedTaskList using list2. */
+		pxDelayedTaskList = &xDelayedTaskList1;
+		pxOverflowDelayedTaskList = &xDelayedTaskList2;
+	}
+	#endif
 }
 /*-----------------------------------------------------------*/
 
@@ -3727,6 +3879,102 @@ static void prvCheckTasksWaitingTermination( void )
 #endif /* INCLUDE_vTaskDelete */
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_DELAYED_TASK_WHEEL == 1 )
+
+static void prvResetNextTaskUnblockTime( void )
+{
+UBaseType_t uxLevel, uxSlot;
+const ListItem_t *pxItem;
+const List_t *pxList;
+TickType_t xTimeToWake;
+
+	/* Every task on a level wakes before every task filed in a later slot of
+	the level above, so the first occupied slot found, searching upwards from
+	level 0 and along each level from the wheel time, holds the next task to
+	unblock.  On the top level the slots before the wheel time belong to the
+	next lap of the tick count, and are not reached until it overflows. */
+	xNextTaskUnblockTime = portMAX_DELAY;
+
+	for( uxLevel = ( UBaseType_t ) 0U; uxLevel < ( UBaseType_t ) taskWHEEL_LEVELS; uxLevel++ )
+	{
+		/* The slot holding the wheel time itself is only ever occupied on
+		level 0, by tasks that wake on the current tick. */
+		for( uxSlot = ( UBaseType_t ) ( ( xDelayedTaskWheelTime >> ( taskWHEEL_BITS * uxLevel ) ) & taskWHEEL_MASK ); uxSlot < ( UBaseType_t ) taskWHEEL_SLOTS; uxSlot++ )
+		{
+			pxList = &( xDelayedTaskWheel[ uxLevel ][ uxSlot ] );
+
+			if( listLIST_IS_EMPTY( pxList ) == pdFALSE )
+			{
+				/* The slot is unsorted: take the earliest wake time in it. */
+				for( pxItem = listGET_HEAD_ENTRY( pxList ); pxItem != listGET_END_MARKER( pxList ); pxItem = listGET_NEXT( pxItem ) )
+				{
+					xTimeToWake = listGET_LIST_ITEM_VALUE( pxItem );
+
+					if( xTimeToWake < xNextTaskUnblockTime )
+					{
+						xNextTaskUnblockTime = xTimeToWake;
+					}
+				}
+
+				return;
+			}
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvInsertDelayedTask( ListItem_t * const pxStateListItem )
+{
+const TickType_t xTimeToWake = listGET_LIST_ITEM_VALUE( pxStateListItem );
+UBaseType_t uxLevel = ( UBaseType_t ) 0U;
+
+	configASSERT( ( TickType_t ) ( xTimeToWake - xDelayedTaskWheelTime ) <= taskWHEEL_MAX_DELAY );
+
+	while( ( uxLevel < ( UBaseType_t ) ( taskWHEEL_LEVELS - 1U ) ) &&
+		   ( ( xTimeToWake >> ( taskWHEEL_BITS * ( uxLevel + 1U ) ) ) != ( xDelayedTaskWheelTime >> ( taskWHEEL_BITS * ( uxLevel + 1U ) ) ) ) )
+	{
+		uxLevel++;
+	}
+
+	vListInsertEnd( &( xDelayedTaskWheel[ uxLevel ][ ( xTimeToWake >> ( taskWHEEL_BITS * uxLevel ) ) & taskWHEEL_MASK ] ), pxStateListItem );
+}
+/*-----------------------------------------------------------*/
+
+static void prvAdvanceDelayedTaskWheel( const TickType_t xNewTime )
+{
+const TickType_t xOldTime = xDelayedTaskWheelTime;
+UBaseType_t uxLevel;
+List_t *pxList;
+ListItem_t *pxItem;
+
+	xDelayedTaskWheelTime = xNewTime;
+
+	/* From the top, refile the slot the wheel time has entered on every level
+	where it changed slot.  Refiling never puts a task back in the same slot,
+	and the refiled tasks may land in a slot of a lower level that is then
+	refiled in turn. */
+	for( uxLevel = ( UBaseType_t ) ( taskWHEEL_LEVELS - 1U ); uxLevel > ( UBaseType_t ) 0U; uxLevel-- )
+	{
+		if( ( xNewTime >> ( taskWHEEL_BITS * uxLevel ) ) != ( xOldTime >> ( taskWHEEL_BITS * uxLevel ) ) )
+		{
+			pxList = &( xDelayedTaskWheel[ uxLevel ][ ( xNewTime >> ( taskWHEEL_BITS * uxLevel ) ) & taskWHEEL_MASK ] );
+
+			while( listLIST_IS_EMPTY( pxList ) == pdFALSE )
+			{
+				pxItem = listGET_HEAD_ENTRY( pxList );
+				( void ) uxListRemove( pxItem );
+				prvInsertDelayedTask( pxItem );
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+}
+
+#else /* configUSE_DELAYED_TASK_WHEEL */
+
 static void prvResetNextTaskUnblockTime( void )
 {
 TCB_t *pxTCB;
@@ -3749,6 +3997,7 @@ TCB_t *pxTCB;
 		xNextTaskUnblockTime = listGET_LIST_ITEM_VALUE( &( ( pxTCB )->xStateListItem ) );
 	}
 }
+#endif /* configUSE_DELAYED_TASK_WHEEL */
 /*-----------------------------------------------------------*/
 
 #if ( ( INCLUDE_xTaskGetCurrentTaskHandle == 1 ) || ( configUSE_MUTEXES == 1 ) )
@@ -4959,13 +5208,13 @@ const TickType_t xConstTickCount = xTickCount;
 			{
 				/* Wake time has overflowed.  Place this item in the overflow
 				list. */
-				vListInsert( pxOverflowDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
+				taskINSERT_DELAYED_TASK( pxOverflowDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
 			}
 			else
 			{
 				/* The wake time has not overflowed, so the current block list
 				is used. */
-				vListInsert( pxDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
+				taskINSERT_DELAYED_TASK( pxDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
 
 				/* If the task entering the blocked state was placed at the
 				head of the list of blocked tasks then xNextTaskUnblockTime
@@ -4994,12 +5243,12 @@ const TickType_t xConstTickCount = xTickCount;
 		if( xTimeToWake < xConstTickCount )
 		{
 			/* Wake time has overflowed.  Place this item in the overflow list. */
-			vListInsert( pxOverflowDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
+			taskINSERT_DELAYED_TASK( pxOverflowDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
 		}
 		else
 		{
 			/* The wake time has not overflowed, so the current block list is used. */
-			vListInsert( pxDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
+			taskINSERT_DELAYED_TASK( pxDelayedTaskList, &( pxCurrentTCB->xStateListItem ) );
 
 			/* If the task entering the blocked state was placed at the head of the
 			list of blocked tasks then xNextTaskUnblockTime needs to be updated
@@ -0,0 +1,114 @@
+import argparse
+import json
+import os
+import subprocess
+import sys
+import time
+
+# Cenários: nome, veículos (0 = modo de tarefas, com os veículos fixos do
+# main.c), linhas e colunas da grade de cruzamentos, minutos simulados,
+# regiões do modo paralelo (0 = trabalhadoras do FreeRTOS) e o limite em
+# segundos reais, após o qual o cenário é interrompido e dado como falho
+CENARIOS = [
+    ('tarefas_2x2', 0, 2, 2, 60, 0, 300),
+    ('tarefas_40x40', 0, 40, 40, 1, 0, 600),
+    ('agentes_1k_4x4', 1000, 4, 4, 30, 0, 300),
+    ('agentes_10k_10x10', 10000, 10, 10, 30, 0, 300),
+    ('agentes_100k_20x20', 100000, 20, 20, 10, 0, 600),
+    ('agentes_1m_40x40', 1000000, 40, 40, 5, 0, 1800),
+    ('regioes_1m_40x40_p64', 1000000, 40, 40, 5, 64, 1800),
+]
+
+SEMENTE = 1  # Semente fixa: cada cenário executa o mesmo trabalho em toda medição
+
+# Função que escreve uma grade de cruzamentos no formato de texto da rede (Project/rede.c)
+def gerar_grade(arquivo, linhas, colunas):
+    with open(arquivo, 'w') as saida:
+        for linha in range(linhas):
+            for coluna in range(colunas):
+                saida.write(f'cruzamento L{linha}C{coluna}\n')
+        for linha in range(linhas):
+            for coluna in range(colunas):
+                cruzamento = linha * colunas + coluna
+                if coluna + 1 < colunas:  # Vias leste-oeste, nos dois sentidos
+                    saida.write(f'via {cruzamento} {cruzamento + 1} 500 60\n')
+                    saida.write(f'via {cruzamento + 1} {cruzamento} 500 60\n')
+                if linha + 1 < linhas:  # Vias norte-sul, nos dois sentidos
+                    saida.write(f'via {cruzamento} {cruzamento + colunas} 500 50\n')
+                    saida.write(f'via {cruzamento + colunas} {cruzamento} 500 50\n')
+
+# Função que lê a linha "metricas: chave=valor ..." impressa com -m
+def ler_metricas(saida):
+    for linha in saida.splitlines():
+        if linha.startswith('metricas:'):
+            metricas = {}
+            for campo in linha.split()[1:]:
+                chave, valor = campo.split('=')
+                metricas[chave] = float(valor) if '.' in valor else int(valor)
+            return metricas
+    return None
+
+# Função que executa um cenário e devolve suas métricas
+def executar_cenario(simulador, diretorio, nome, veiculos, linhas, colunas, minutos, regioes, limite):
+    rede = os.path.join(diretorio, f'grade_{linhas}x{colunas}.txt')
+    if not os.path.exists(rede):
+        gerar_grade(rede, linhas, colunas)
+
+    comando = [simulador, '-r', rede, '-t', str(minutos * 60), '-s', str(SEMENTE), '-m']
+    if veiculos > 0:
+        comando += ['-a', str(veiculos)]
+    if regioes > 0:
+        comando += ['-p', str(regioes)]
+    try:
+        processo = subprocess.run(comando, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True,
+                                  timeout=limite)
+    except subprocess.TimeoutExpired as expirado:
+        erros = expirado.stderr or ''
+        if isinstance(erros, bytes):  # Interrompido, o processo pode deixar a saída sem decodificar
+            erros = erros.decode(errors='replace')
+        raise RuntimeError(f'Cenário {nome} excedeu o limite de {limite} s\n{erros.strip()}'.rstrip())
+    metricas = ler_metricas(processo.stdout)
+    if processo.returncode != 0 or metricas is None:
+        raise RuntimeError(f'Cenário {nome} falhou (código {processo.returncode})\n{processo.stderr.strip()}'.rstrip())
+
+    modo = 'regioes' if regioes > 0 else 'agentes' if veiculos > 0 else 'tarefas'
+    return {'nome': nome, 'modo': modo, 'veiculos': veiculos, 'regioes': regioes,
+            'cruzamentos': linhas * colunas, 'minutos': minutos, **metricas}
+
+def main():
+    parser = argparse.ArgumentParser(description='Executa os cenários de desempenho do simulador')
+    parser.add_argument('--simulador', default='./build/FreeRTOS-ubuntu')
+    parser.add_argument('--saida', default='./build/bench.json')
+    parser.add_argument('--porte', default='')
+    parser.add_argument('--cenario', action='append', help='executa só os cenários com este nome')
+    args = parser.parse_args()
+
+    diretorio = os.path.join(os.path.dirname(args.saida) or '.', 'bench')
+    os.makedirs(diretorio, exist_ok=True)
+
+    resultados = []
+    print(f'{"cenário":<22} {"sim/s real":>10} {"reserva":>9} {"partida":>9} {"trocas/s":>12} {"atualiz./s":>12} {"pico RSS":>10}')
+    for cenario in CENARIOS:
+        if args.cenario and cenario[0] not in args.cenario:
+            continue
+        resultado = executar_cenario(args.simulador, diretorio, *cenario)
+        resultados.append(resultado)
+        print(f'{resultado["nome"]:<22} {resultado["simulado_por_real"]:>10.1f} {resultado["reserva_s"]:>8.3f}s {resultado["partida_s"]:>8.3f}s {resultado["trocas_por_s"]:>12.0f} '
+              f'{resultado["atualizacoes_por_s"]:>12.0f} {resultado["pico_rss_kb"] / 1024:>8.1f}MB')
+
+    try:
+        revisao = subprocess.run(['git', 'rev-parse', '--short', 'HEAD'], stdout=subprocess.PIPE,
+                                 stderr=subprocess.DEVNULL, text=True).stdout.strip()
+    except OSError:
+        revisao = ''
+    with open(args.saida, 'w') as saida:
+        json.dump({'revisao': revisao, 'porte': args.porte, 'data': time.strftime('%Y-%m-%dT%H:%M:%S'),
+                   'cenarios': resultados}, saida, indent=2)
+    print(f'Resultados em {args.saida}')
+
+if __name__ == '__main__':
+    try:
+        main()
+    except RuntimeError as erro:
+        print(erro, file=sys.stderr)
+        sys.exit(1)
@@ -1,85 +1,77 @@
 import subprocess
-import re
+import struct
 import matplotlib.pyplot as plt
 import matplotlib.animation as animation
 import time
 
-# Função para executar o código C e capturar a saída do terminal
-def executar_codigo_c(limite_linhas=100, timeout=10):
+# Formato do registro binário de eventos (Project/eventos.h)
+CABECALHO_EVENTOS = struct.Struct('<8sIIIII')  # mágica, versão, tamanho do evento, ticks por segundo, cruzamentos, tamanho dos nomes
+EVENTO = struct.Struct('<IIIfHBc')  # tick, veículo, cruzamento, velocidade, tempo de percurso, tipo, movimento
+EVENTOS_VERSAO = 1
+EVENTO_FASE, EVENTO_APROXIMACAO, EVENTO_TRAVESSIA, EVENTO_PROXIMO_CRUZAMENTO, EVENTO_FIM_JORNADA = range(1, 6)
+FASES = {'N': 'NS', 'E': 'EW', 'X': 'XX'}
+
+# Lê exatamente 'tamanho' bytes do fluxo, ou None no fim do fluxo
+def ler_exato(fluxo, tamanho):
+    dados = b''
+    while len(dados) < tamanho:
+        parte = fluxo.read(tamanho - len(dados))
+        if not parte:
+            return None
+        dados += parte
+    return dados
+
+# Função que decodifica o fluxo binário de eventos, produzindo um dicionário por evento
+def decodificar_eventos(fluxo):
+    cabecalho = ler_exato(fluxo, CABECALHO_EVENTOS.size)
+    if cabecalho is None:
+        return
+    magica, versao, tamanho_evento, ticks_por_segundo, num_cruzamentos, tamanho_nomes = CABECALHO_EVENTOS.unpack(cabecalho)
+    if magica.rstrip(b'\0') != b'EVENTOS' or versao != EVENTOS_VERSAO or tamanho_evento != EVENTO.size:
+        raise ValueError('Fluxo de eventos em formato desconhecido')
+    nomes = [nome.decode() for nome in ler_exato(fluxo, tamanho_nomes).split(b'\0')[:num_cruzamentos]]
+
+    while True:
+        dados = ler_exato(fluxo, EVENTO.size)
+        if dados is None:
+            return
+        tick, veiculo, cruzamento, velocidade, tempo_percurso, tipo, movimento = EVENTO.unpack(dados)
+        yield {'tempo': tick / ticks_por_segundo, 'tipo': tipo, 'veiculo': veiculo, 'cruzamento': nomes[cruzamento],
+               'movimento': movimento.decode(), 'velocidade': velocidade, 'tempo_percurso': tempo_percurso}
+
+# Função para executar o código C e capturar os eventos binários da saída padrão
+def executar_codigo_c(limite_eventos=100, timeout=10):
+    eventos = []
     try:
-        processo = subprocess.Popen(['./build/FreeRTOS-ubuntu'], stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
-        
-        # Leitura em tempo real de stdout e stderr
-        stdout_lines = []
-        stderr_lines = []
+        processo = subprocess.Popen(['./build/FreeRTOS-ubuntu', '-e', '-'], stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
         start_time = time.time()
-        
-        while True:
-            stdout_line = processo.stdout.readline()
-            stderr_line = processo.stderr.readline()
-            
-            if stdout_line:
-                print(stdout_line.strip())  # Imprime a saída em tempo real
-                stdout_lines.append(stdout_line)
-                if len(stdout_lines) >= limite_linhas:
-                    processo.terminate()
-                    break
-            if stderr_line:
-                print(stderr_line.strip())  # Imprime a saída de erro em tempo real
-                stderr_lines.append(stderr_line)
-            
-            # Verifica se o tempo limite foi atingido
-            if time.time() - start_time > timeout:
-                processo.terminate()
-                break
-            
-            if not stdout_line and not stderr_line and processo.poll() is not None:
+
+        for evento in decodificar_eventos(processo.stdout):
+            eventos.append(evento)
+            # Verifica se o limite de eventos ou o tempo limite foi atingido
+            if len(eventos) >= limite_eventos or time.time() - start_time > timeout:
                 break
-        
-        stdout = ''.join(stdout_lines)
-        stderr = ''.join(stderr_lines)
-        
-        if stderr:
-            print("Erro ao executar o código C:", stderr)
-        
-        return stdout
+
+        processo.terminate()
     except Exception as e:
         print("Erro ao executar o código C:", e)
-        return ""
 
-# Função para parsear a saída do terminal
-def parsear_saida(saida):
+    return eventos
+
+# Função que agrupa os eventos no estado final de veículos e cruzamentos
+def agrupar_eventos(eventos):
     veiculos = {}
     cruzamentos = {}
-    
-    linhas = saida.split('\n')
-    for linha in linhas:
-        # Regex para capturar informações dos veículos
-        match_veiculo = re.match(r'Veículo (\d+) se aproximando do cruzamento (\w) para mover (\w) com velocidade ([\d.]+) km/h. Tempo de percurso: (\d+) segundos', linha)
-        if match_veiculo:
-            id_veiculo = int(match_veiculo.group(1))
-            cruzamento = match_veiculo.group(2)
-            movimento = match_veiculo.group(3)
-            velocidade = float(match_veiculo.group(4))
-            tempo_percurso = int(match_veiculo.group(5))
-            veiculos[id_veiculo] = {'cruzamento': cruzamento, 'movimento': movimento, 'velocidade': velocidade, 'tempo_percurso': tempo_percurso}
-        
-        # Regex para capturar informações dos cruzamentos
-        match_cruzamento = re.match(r'Cruzamento (\w): Fase (\w+)', linha)
-        if match_cruzamento:
-            cruzamento = match_cruzamento.group(1)
-            fase = match_cruzamento.group(2)
-            cruzamentos[cruzamento] = fase
-        
-        # Regex para capturar movimento dos veículos
-        match_movimento = re.match(r'Veículo (\d+) atravessou o cruzamento (\w) em (\w+)', linha)
-        if match_movimento:
-            id_veiculo = int(match_movimento.group(1))
-            cruzamento = match_movimento.group(2)
-            movimento = match_movimento.group(3)
-            if id_veiculo in veiculos:
-                veiculos[id_veiculo]['cruzamento'] = cruzamento
-    
+
+    for evento in eventos:
+        if evento['tipo'] == EVENTO_APROXIMACAO:
+            veiculos[evento['veiculo']] = {'cruzamento': evento['cruzamento'], 'movimento': evento['movimento'],
+                                           'velocidade': evento['velocidade'], 'tempo_percurso': evento['tempo_percurso']}
+        elif evento['tipo'] == EVENTO_FASE:
+            cruzamentos[evento['cruzamento']] = FASES.get(evento['movimento'], evento['movimento'])
+        elif evento['tipo'] == EVENTO_TRAVESSIA and evento['veiculo'] in veiculos:
+            veiculos[evento['veiculo']]['cruzamento'] = evento['cruzamento']
+
     return veiculos, cruzamentos
 
 # Função de atualização para animação
@@ -106,11 +98,11 @@ posicoes_cruzamentos = {
     'D': (DISTANCIA_CRUZAMENTO, -DISTANCIA_CRUZAMENTO)
 }
 
-# Captura a saída do terminal do código C
-saida_terminal = executar_codigo_c(limite_linhas=100, timeout=10)
+# Captura os eventos do código C
+eventos = executar_codigo_c(limite_eventos=100, timeout=10)
 
-# Parseia a saída do terminal
-veiculos, cruzamentos = parsear_saida(saida_terminal)
+# Agrupa os eventos em veículos e cruzamentos
+veiculos, cruzamentos = agrupar_eventos(eventos)
 
 # Verifica se há dados para exibir
 if not veiculos: